@@ -14,17 +14,18 @@
 #include <pthread.h>
 #include <assert.h>
 
-#include "gpio_io.c"			/* GPIO routines */
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
 #include "timed_wait.c"			/* timed_wait() */
 
 /*
  * GPIO definitions :
  */
-static const int g_enable	= 17;		/* L298 EnA and EnB */
-static const int g_in1		= 27;		/* L298 In1 */
-static const int g_in2		= 22;		/* L298 In2 */
-static const int g_in3		= 23;		/* L298 In3 */
-static const int g_in4		= 24;		/* L298 In4 */
+GPIO_PIN(g_enable,17);				/* L298 EnA and EnB */
+GPIO_PIN(g_in1,27);				/* L298 In1 */
+GPIO_PIN(g_in2,22);				/* L298 In2 */
+GPIO_PIN(g_in3,23);				/* L298 In3 */
+GPIO_PIN(g_in4,24);				/* L298 In4 */
 
 static volatile int stepper_mode = 0;		/* Stepper mode - 1 */
 static volatile float step_time	= 0.1;		/* Step time in seconds */
@@ -32,6 +33,7 @@ static volatile float step_time	= 0.1;		/* Step time in seconds */
 static volatile char cmd	= 0;		/* Thread command when non-zero */
 static volatile char stop	= 0;		/* Stop thead when non-zero */
 static volatile char stopped	= 0;		/* True when thread has stopped */
+static const char *rt_arg	= 0;		/* -R cpu[,priority] */
 
 static pthread_mutex_t mutex;			/* For inter-thread locks */
 static pthread_cond_t cond;			/* For inter-thread signaling */
@@ -53,18 +55,26 @@ await(float seconds) {
  */
 static inline void
 enable(int enable) {
-	gpio_write(g_enable,enable);
+	g_enable_write(enable);
 }
 
 /*
- * Drive the appropriate GPIO outputs :
+ * Drive the appropriate GPIO outputs (one set and one clear store) :
  */
 static void
 drive(int L1L2) {
-	gpio_write(g_in1,L1L2&0x08);
-	gpio_write(g_in2,L1L2&0x04);
-	gpio_write(g_in3,L1L2&0x02);
-	gpio_write(g_in4,L1L2&0x01);
+	const unsigned mask = 1 << g_in1 | 1 << g_in2 | 1 << g_in3 | 1 << g_in4;
+	unsigned value = 0;
+
+	if ( L1L2 & 0x08 )
+		value |= 1 << g_in1;
+	if ( L1L2 & 0x04 )
+		value |= 1 << g_in2;
+	if ( L1L2 & 0x02 )
+		value |= 1 << g_in3;
+	if ( L1L2 & 0x01 )
+		value |= 1 << g_in4;
+	gpio_write_mask(value,mask);
 }
 
 /*
@@ -127,6 +137,9 @@ controller(void *ignored) {
 	int command;
 	int direction;
 
+	if ( rt_arg )
+		rt_optarg(rt_arg);		/* Real-time stepping thread */
+
 	for ( stopped=1;; ) {
 		command = get_cmd();
 		direction = command == 'F' ? 1 : -1;
@@ -195,9 +208,21 @@ main(int argc,char **argv) {
 	pthread_t tid;				/* Thread id */
 	int tty = 0;				/* Use stdin */
 	struct termios sv_ios, ios;
-	int rc, quit;
+	gpio_fsel_t tx;				/* GPIO configuration */
+	int rc, quit, optch;
 	char ch, lcmd = 0;
 
+	while ( (optch = getopt(argc,argv,"R:h")) != EOF )
+		switch ( optch ) {
+		case 'R' :
+			rt_arg = optarg;
+			break;
+		case 'h' :
+		default :
+			fprintf(stderr,"Usage: %s [-R cpu[,priority]]\n",argv[0]);
+			exit(1);
+		}
+
  	rc = tcgetattr(tty,&sv_ios);		/* Save current settings */
 	assert(!rc);
 	ios = sv_ios;
@@ -210,11 +235,14 @@ main(int argc,char **argv) {
 	 * Initialize and configure GPIO pins :
 	 */
 	gpio_init();
-	gpio_config(g_enable,Output);
-	gpio_config(g_in1,Output);
-	gpio_config(g_in2,Output);
-	gpio_config(g_in3,Output);
-	gpio_config(g_in4,Output);
+	gpio_fsel_begin(&tx);
+	gpio_fsel_dir(&tx,g_enable,Output);
+	gpio_fsel_dir(&tx,g_in1,Output);
+	gpio_fsel_dir(&tx,g_in2,Output);
+	gpio_fsel_dir(&tx,g_in3,Output);
+	gpio_fsel_dir(&tx,g_in4,Output);
+	rc = gpio_fsel_commit(&tx);		/* GPFSEL1 and GPFSEL2 */
+	assert(!rc);
 
 	enable(0);				/* Turn off output */
 	set_mode(0);				/* Default is one phase mode */
@@ -1,21 +1,36 @@
 /*********************************************************************
- * dht11.c : Direct GPIO access reading DHT11 humidity and temp sensor.
+ * dht11.c : Read a DHT11 or DHT22 humidity and temperature sensor
+ *
+ * ./dht11 [-t 11|22] [-p gpio] [-R cpu[,prio]]
+ *
+ * The line is requested from the kernel (gpio_line.h) and turned
+ * around in place for the start pulse. The sensor's reply arrives as
+ * kernel timestamped edges, decoded by pulse widths in microseconds
+ * (dht_read.h), so the CPU sleeps through the frame instead of
+ * counting loop iterations. With GPIO_BACKEND=sim a simulated sensor
+ * answers. To poll many sensors, see dhtsched.c.
+ *
+ * Reads are 2 seconds apart; failures are retried as dht_retry_ms()
+ * advises. On SIGINT the error counts and the histogram of bit
+ * widths (dht_stats.h) are reported.
  *********************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
+#include <string.h>
 #include <unistd.h>
-#include <errno.h>
-#include <setjmp.h>
-#include <sys/mman.h>
 #include <signal.h>
+#include <time.h>
 
-#include "gpio_io.c"			/* GPIO routines */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
+#include "dht_read.h"			/* dht_read() */
+#include "dht_stats.h"			/* Error counts and histograms */
 #include "timed_wait.c"			/* timed_wait() */
 
-static const int gpio_dht11 = 22;	/* GPIO pin */
-static jmp_buf timeout_exit;		/* longjmp on timeout */
+#define DHT_READ_MS	2000		/* Normal spacing of reads */
+
+static int gpio_dht = 22;		/* GPIO pin */
+static dht_type_t dht_type = dht11;	/* Sensor type (-t) */
 static int is_signaled = 0;		/* Exit program if signaled */
 
 /*
@@ -26,138 +41,74 @@ sigint_handler(int signo) {
 	is_signaled = 1;		/* Signal to exit program */
 }
 
-/*
- * Read the GPIO line status :
- */
-static inline unsigned
-gread(void) {
-	return gpio_read(gpio_dht11);
-}
-
-/*
- * Wait until the GPIO line goes low :
- */
-static inline unsigned
-wait_until_low(void) {
-	const unsigned maxcount = 12000;
-	unsigned count = 0;
-
-	while ( gread() )
-		if ( ++count >= maxcount || is_signaled )
-			longjmp(timeout_exit,1);
-	return count;
-}
-
-/*
- * Wait until the GPIO line goes high :
- */
-static inline unsigned
-wait_until_high(void) {
-	unsigned count = 0;
-
-	while ( !gread() )
-		++count;
-	return count;
-}
-
-/*
- * Read 1 bit from the DHT11 sensor :
- */
-static unsigned
-rbit(void) {
-	unsigned bias;
-	unsigned lo_count, hi_count;
-
-	wait_until_low();
-	lo_count = wait_until_high();
-	hi_count = wait_until_low();
-
-	bias = lo_count / 3;
-
-	return hi_count + bias > lo_count ? 1 : 0;
-}	
-
-/*
- * Read 1 byte from the DHT11 sensor :
- */
-static unsigned
-rbyte(void) {
-	unsigned x, u = 0;
-
-	for ( x=0; x<8; ++x )
-		u = (u << 1) | rbit();
-	return u;
-}
-
-/*
- * Read 32 bits of data + 8 bit checksum from the
- * DHT sensor. Returns relative humidity and
- * temperature in Celcius when successful. The
- * function returns zero if there was a checksum
- * error.
- */
-static int
-rsensor(int *relhumidity,int *celsius) {
-	unsigned char u[5], cs = 0, x;
-
-	for ( x=0; x<5; ++x ) {
-		u[x] = rbyte();
-		if ( x < 4 )		/* Only checksum data.. */
-			cs += u[x];	/* Checksum */
-	}
-
-	if ( (cs & 0xFF)  == u[4] ) {
-		*relhumidity = (int)u[0];
-		*celsius   = (int)u[2];
-		return 1;
-	}
-	return 0;
-}
-
 /*
  * Main program :
  */
 int
 main(int argc,char **argv) {
-	int relhumidity = 0, celsius = 0;
+	int rh10 = 0, temp10 = 0;
 	int errors = 0, timeouts = 0, readings = 0;
+	dht_sensor_t sensor;
+	dht_frame_t frame;
+	dht_status_t status;
+	dht_stats_t stats;
 	unsigned wait;
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"t:p:R:h")) != EOF )
+		switch ( optch ) {
+		case 't' :
+			if ( !strcmp(optarg,"22") || !strcmp(optarg,"2302") )
+				dht_type = dht22;
+			else if ( strcmp(optarg,"11") )
+				goto usage;
+			break;
+		case 'p' :
+			gpio_dht = atoi(optarg);
+			break;
+		case 'R' :
+			rt_optarg(optarg);	/* Real-time CPU[,priority] */
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,"Usage: %s [-t 11|22] [-p gpio] [-R cpu[,priority]]\n",argv[0]);
+			exit(1);
+		}
 
 	signal(SIGINT,sigint_handler);		/* Trap on SIGINT */
 
-	gpio_init();    			/* Initialize GPIO access */
-	gpio_config(gpio_dht11,Input);		/* Set GPIO pin as Input */
-
-	for (;;) {
-		if ( setjmp(timeout_exit) ) {	/* Timeouts go here */
-			if ( is_signaled )	/* SIGINT? */
-				break;		/* Yes, then exit loop */
-			fprintf(stderr,"(Timeout # %d)\n",++timeouts);
-			wait = 5;
-		} else	wait = 2;
-
-		wait_until_high();		/* Wait GPIO line to go high */
-		timed_wait(wait,0,0);		/* Pause for sensor ready */
-
-		gpio_config(gpio_dht11,Output);	/* Output mode */
-		gpio_write(gpio_dht11,0);   	/* Bring line low */
-		timed_wait(0,30000,0);		/* Hold low min of 18ms */
-		gpio_write(gpio_dht11,1);   	/* Bring line high */
-
-		gpio_config(gpio_dht11,Input);	/* Input mode */
-		wait_until_low();		/* Wait for low signal */
-		wait_until_high();		/* Wait for return to high */
+	if ( dht_open(&sensor,gpio_dht,dht_type) )
+		return 1;
 
-		if ( rsensor(&relhumidity,&celsius) )
-			printf("RH %d%% Temp %d C Reading %d\n",relhumidity,celsius,++readings);
-		else	fprintf(stderr,"(Error # %d)\n",++errors);
+	dht_stats_init(&stats);
+	wait = DHT_READ_MS;
+	while ( !is_signaled ) {
+		timed_wait(wait/1000,wait%1000*1000,0);	/* Pause for sensor ready */
+		if ( is_signaled )
+			break;
+
+		status = dht_read(&sensor,&frame);
+		dht_stats_add(&stats,status,&frame);
+		wait = DHT_READ_MS;
+		if ( status == dht_ok ) {
+			dht_convert(&frame,dht_type,&rh10,&temp10);
+			if ( dht_type == dht11 )
+				printf("RH %d%% Temp %d C Reading %d\n",rh10/10,temp10/10,++readings);
+			else	printf("RH %.1f%% Temp %.1f C Reading %d\n",rh10/10.0,temp10/10.0,++readings);
+		} else	{
+			if ( status == dht_checksum || status == dht_bit_width )
+				fprintf(stderr,"(Error # %d: %s)\n",++errors,dht_status_name(status));
+			else	fprintf(stderr,"(Timeout # %d: %s)\n",++timeouts,dht_status_name(status));
+			wait = dht_retry_ms(&stats,dht_type,DHT_READ_MS);
+		}
 	}
 
-	gpio_config(gpio_dht11,Input);		/* Set pin to input mode */
+	dht_close(&sensor);			/* Leave it an input */
 
 	puts("\nProgram exited due to SIGINT:\n");
-	printf("Last Read: RH %d%% Temp %d C, %d errors, %d timeouts, %d readings\n",
-		relhumidity,celsius,errors,timeouts,readings);
+	printf("Last Read: RH %.1f%% Temp %.1f C, %d errors, %d timeouts, %d readings\n",
+		rh10/10.0,temp10/10.0,errors,timeouts,readings);
+	dht_stats_print(stdout,&stats);
 	return 0;
 }
 
@@ -0,0 +1,78 @@
+/*********************************************************************
+ * dht_client.c : Query the readings cached by dhtsched
+ *********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+#include "dht_client.h"
+
+/*********************************************************************
+ * Ask the daemon at path for a reading of gpio no older than
+ * max_age_ms. Returns 0 with *reading filled in, or -1 with errno
+ * set (ENOENT for a GPIO the daemon does not poll, ETIMEDOUT when
+ * no answer came within DHT_QUERY_MS).
+ *********************************************************************/
+int
+dht_query(const char *path,int gpio,unsigned max_age_ms,dht_reading_t *reading) {
+	struct sockaddr_un addr;
+	struct timeval tv;
+	char buf[DHT_LINE_MAX];
+	int fd, n, len = 0, status;
+
+	if ( (fd = socket(AF_UNIX,SOCK_STREAM,0)) < 0 )
+		return -1;
+
+	tv.tv_sec = DHT_QUERY_MS / 1000;
+	tv.tv_usec = DHT_QUERY_MS % 1000 * 1000;
+	setsockopt(fd,SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof tv);
+
+	memset(&addr,0,sizeof addr);
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path,path,sizeof addr.sun_path - 1);
+	if ( connect(fd,(struct sockaddr *)&addr,sizeof addr) )
+		goto fail;
+
+	n = snprintf(buf,sizeof buf,"%d %u\n",gpio,max_age_ms);
+	if ( write(fd,buf,n) != n )
+		goto fail;
+
+	while ( len < (int)sizeof buf - 1 && !memchr(buf,'\n',len) ) {
+		if ( (n = read(fd,buf+len,sizeof buf - 1 - len)) <= 0 ) {
+			if ( !n || errno == EAGAIN )
+				errno = n ? ETIMEDOUT : ECONNRESET;
+			goto fail;
+		}
+		len += n;
+	}
+	buf[len] = 0;
+	close(fd);
+
+	if ( sscanf(buf,"%d %d %d %d %ld",&reading->gpio,&status,
+	  &reading->rh10,&reading->temp10,&reading->age_ms) != 5 ) {
+		errno = EPROTO;
+		return -1;
+	}
+	if ( status < 0 ) {
+		errno = ENOENT;
+		return -1;
+	}
+	reading->status = (dht_status_t)status;
+	return 0;
+
+fail:	n = errno;
+	close(fd);
+	errno = n;
+	return -1;
+}
+
+/*********************************************************************
+ * End dht_client.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
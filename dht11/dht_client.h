@@ -0,0 +1,38 @@
+/*********************************************************************
+ * dht_client.h : Query the readings cached by dhtsched
+ *
+ * dhtsched -u path serves its latest readings on a Unix stream
+ * socket. A client sends one line, "gpio max_age_ms", and gets one
+ * line back, "gpio status rh10 temp10 age_ms". A reading no older
+ * than max_age_ms is answered at once; otherwise the sensor is read
+ * as soon as its minimum interval allows and the answer waits for
+ * it. age_ms is -1 before the first good reading, and status is -1
+ * for a GPIO the daemon does not poll.
+ *********************************************************************/
+
+#ifndef DHT_CLIENT_H
+#define DHT_CLIENT_H
+
+#include "dht_decode.h"
+
+#define DHT_SOCKET	"/var/run/dht.sock"	/* Default socket path */
+#define DHT_QUERY_MS	5000		/* Longest wait for an answer */
+#define DHT_LINE_MAX	64		/* Longest request or reply */
+
+typedef struct {
+	int		gpio;		/* GPIO of the sensor */
+	dht_status_t	status;		/* Status of its last read */
+	int		rh10;		/* Last good RH in tenths of % */
+	int		temp10;		/* Last good temp in tenths of C */
+	long		age_ms;		/* Age of that reading, or -1 */
+} dht_reading_t;
+
+int dht_query(const char *path,int gpio,unsigned max_age_ms,dht_reading_t *reading);
+
+#endif /* DHT_CLIENT_H */
+
+/*********************************************************************
+ * End dht_client.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
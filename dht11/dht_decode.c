@@ -0,0 +1,181 @@
+/*********************************************************************
+ * dht_decode.c : DHT11/DHT22 frames from timestamped edges
+ *********************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "dht_decode.h"
+
+const dht_rule_t dht_default_rule = {
+	DHT_ONE_US,			/* Fixed threshold */
+	0,
+	DHT_ONE_US - DHT_ZERO_MAX_US	/* Guard band 40..56 us */
+};
+
+/*********************************************************************
+ * Decode the edges captured after the start pulse. Each high pulse
+ * (rising edge, then falling) is a bit, except the sensor's 80 us
+ * response and any glitch before it, so the last 40 pulses are the
+ * data. Bits are classified by their high time, as the rule says.
+ *********************************************************************/
+dht_status_t
+dht_decode_rule(const gpio_edge_t *edges,unsigned n,dht_frame_t *frame,const dht_rule_t *rule) {
+	unsigned lo[DHT_MAX_EDGES], hi[DHT_MAX_EDGES];
+	unsigned x, np = 0, b, guessed = 0, thr;
+	unsigned char cs;
+
+	memset(frame,0,sizeof *frame);
+	for ( x=1; x+1<n && np<DHT_MAX_EDGES; ++x ) {
+		if ( !edges[x].level || edges[x-1].level || edges[x+1].level )
+			continue;		/* Not falling, rising, falling */
+		lo[np] = (edges[x].ns - edges[x-1].ns) / 1000;
+		hi[np++] = (edges[x+1].ns - edges[x].ns) / 1000;
+	}
+
+	if ( !n )
+		return dht_no_response;
+	if ( np < DHT_BITS )
+		return dht_short_frame;
+
+	for ( b=0, x=np-DHT_BITS; b<DHT_BITS; ++b, ++x ) {
+		frame->lo_us[b] = lo[x];
+		frame->hi_us[b] = hi[x];
+		thr = rule->lo_pct ? lo[x] * rule->lo_pct / 100 : rule->one_us;
+		frame->bytes[b/8] = frame->bytes[b/8] << 1 | (hi[x] > thr);
+		if ( hi[x] + rule->guard_us > thr && hi[x] < thr + rule->guard_us )
+			++guessed;
+	}
+
+	if ( guessed )
+		return dht_bit_width;
+	cs = frame->bytes[0] + frame->bytes[1] + frame->bytes[2] + frame->bytes[3];
+	return cs == frame->bytes[4] ? dht_ok : dht_checksum;
+}
+
+dht_status_t
+dht_decode(const gpio_edge_t *edges,unsigned n,dht_frame_t *frame) {
+	return dht_decode_rule(edges,n,frame,&dht_default_rule);
+}
+
+/*********************************************************************
+ * Parse a rule: "us" is a fixed threshold, "pct%" relative to the
+ * bit's low time, either optionally followed by ",guard_us".
+ * Returns 0, or -1 if not a rule.
+ *********************************************************************/
+int
+dht_rule_parse(const char *arg,dht_rule_t *rule) {
+	char *ep;
+	unsigned v = strtoul(arg,&ep,10);
+
+	rule->one_us = rule->lo_pct = rule->guard_us = 0;
+	if ( *ep == '%' ) {
+		rule->lo_pct = v;
+		++ep;
+	} else	rule->one_us = v;
+	if ( *ep == ',' )
+		rule->guard_us = strtoul(ep+1,&ep,10);
+	return *ep || !v ? -1 : 0;
+}
+
+/*********************************************************************
+ * Edges from n level samples taken every period_ns from t0, as a
+ * logic analyser or register polling records them. An edge is
+ * stamped with the first sample at its new level. Returns the number
+ * stored, at most max.
+ *********************************************************************/
+unsigned
+dht_sample_edges(const unsigned char *levels,unsigned n,unsigned long long t0,unsigned period_ns,int gpio,gpio_edge_t *edges,unsigned max) {
+	unsigned x, ne = 0;
+
+	for ( x=1; x<n && ne<max; ++x ) {
+		if ( !levels[x] == !levels[x-1] )
+			continue;
+		edges[ne].ns = t0 + (unsigned long long)x * period_ns;
+		edges[ne].gpio = gpio;
+		edges[ne++].level = levels[x] ? 1 : 0;
+	}
+	return ne;
+}
+
+/*********************************************************************
+ * Relative humidity and temperature (Celsius) of a good frame, in
+ * tenths
+ *********************************************************************/
+void
+dht_convert(const dht_frame_t *frame,dht_type_t type,int *rh10,int *temp10) {
+	const unsigned char *u = frame->bytes;
+
+	if ( type == dht22 ) {
+		*rh10 = u[0] << 8 | u[1];
+		*temp10 = (u[2] & 0x7F) << 8 | u[3];
+		if ( u[2] & 0x80 )
+			*temp10 = -*temp10;
+	} else	{
+		*rh10 = u[0] * 10 + (u[1] < 10 ? u[1] : 0);
+		*temp10 = u[2] * 10 + ((u[3] & 0x7F) < 10 ? u[3] & 0x7F : 0);
+		if ( u[3] & 0x80 )
+			*temp10 = -*temp10;
+	}
+}
+
+/*********************************************************************
+ * The frame bytes a sensor sends for a reading (the inverse of
+ * dht_convert(), for simulation)
+ *********************************************************************/
+void
+dht_encode(dht_type_t type,int rh10,int temp10,unsigned char bytes[5]) {
+	unsigned t = abs(temp10);
+
+	if ( type == dht22 ) {
+		bytes[0] = rh10 >> 8;
+		bytes[1] = rh10;
+		bytes[2] = (t >> 8 & 0x7F) | (temp10 < 0 ? 0x80 : 0);
+		bytes[3] = t;
+	} else	{
+		bytes[0] = rh10 / 10;
+		bytes[1] = rh10 % 10;
+		bytes[2] = t / 10;
+		bytes[3] = t % 10 | (temp10 < 0 ? 0x80 : 0);
+	}
+	bytes[4] = bytes[0] + bytes[1] + bytes[2] + bytes[3];
+}
+
+/*********************************************************************
+ * The edges of an ideal frame, for a line released at time t0.
+ * Returns the number stored (84).
+ *********************************************************************/
+unsigned
+dht_synth(const unsigned char bytes[5],unsigned long long t0,int gpio,gpio_edge_t *edges) {
+	unsigned long long t = t0 + 30000;	/* Sensor responds */
+	unsigned n = 0, b;
+	int bit;
+
+#define EDGE(lvl,us) do { edges[n].ns = t; edges[n].gpio = gpio; \
+	edges[n++].level = lvl; t += (us) * 1000ULL; } while (0)
+
+	EDGE(0,80);				/* Response */
+	EDGE(1,80);
+	for ( b=0; b<DHT_BITS; ++b ) {
+		bit = bytes[b/8] >> (7 - b%8) & 1;
+		EDGE(0,50);
+		EDGE(1,bit ? 70 : 27);
+	}
+	EDGE(0,50);
+	EDGE(1,0);				/* Released */
+#undef EDGE
+	return n;
+}
+
+const char *
+dht_status_name(dht_status_t status) {
+	static const char *names[] = { "ok", "no response", "short frame", "checksum", "bit width" };
+
+	return (unsigned)status < sizeof names / sizeof names[0] ? names[status] : "?";
+}
+
+/*********************************************************************
+ * End dht_decode.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
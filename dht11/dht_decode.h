@@ -0,0 +1,79 @@
+/*********************************************************************
+ * dht_decode.h : DHT11/DHT22 frames from timestamped edges
+ *
+ * After the start pulse the sensor answers 80 us low, 80 us high,
+ * then sends 40 bits, each 50 us low followed by 26-28 us high for
+ * a 0 or 70 us high for a 1, and releases the line. dht_decode()
+ * classifies the bits by their measured high time, so it works
+ * from kernel edge timestamps at any CPU speed. A high time in the
+ * guard band around DHT_ONE_US is only a guess, so such frames are
+ * rejected as dht_bit_width rather than trusted to the checksum.
+ *
+ * dht_decode_rule() takes the classification as a parameter: a fixed
+ * threshold, or one relative to each bit's own low time (lo_pct 67
+ * is the old counting loop's "hi + lo/3 > lo" bias), which follows a
+ * sensor whose clock runs fast or slow. dht_sample_edges() turns
+ * level samples into edges, so recordings of either kind decode
+ * offline (dhtdecode.c, dhtbench.c).
+ *
+ * Readings are in tenths: DHT22 (AM2302) sends 16 bit humidity and
+ * sign + 15 bit temperature in tenths, the DHT11 whole units with a
+ * tenths byte (0 on older parts).
+ *********************************************************************/
+
+#ifndef DHT_DECODE_H
+#define DHT_DECODE_H
+
+#include "gpio_line.h"			/* gpio_edge_t (libgpio) */
+
+#define DHT_BITS	40		/* Bits in a frame */
+#define DHT_MAX_EDGES	100		/* More than a frame's 84 */
+#define DHT_ONE_US	48		/* High longer than this is a 1 */
+#define DHT_ZERO_MAX_US	40		/* Longest believable 0 high time */
+#define DHT_ONE_MIN_US	56		/* Shortest believable 1 high time */
+
+typedef enum {
+	dht11 = 0,			/* DHT11 */
+	dht22				/* DHT22 / AM2302 */
+} dht_type_t;
+
+typedef enum {
+	dht_ok = 0,			/* Good frame */
+	dht_no_response,		/* No edges from the sensor */
+	dht_short_frame,		/* Fewer than 40 bits */
+	dht_checksum,			/* Checksum mismatch */
+	dht_bit_width			/* A bit in the guard band */
+} dht_status_t;
+
+#define DHT_NSTATUS	5		/* Number of dht_status_t values */
+
+typedef struct {
+	unsigned	one_us;		/* Fixed: high longer than this is a 1 */
+	unsigned	lo_pct;		/* Else (if > 0): high > lo_pct% of low */
+	unsigned	guard_us;	/* Reject bits this close to threshold */
+} dht_rule_t;
+
+extern const dht_rule_t dht_default_rule;
+
+typedef struct {
+	unsigned char	bytes[5];	/* 4 data bytes and the checksum */
+	unsigned	lo_us[DHT_BITS];/* Low time before each bit */
+	unsigned	hi_us[DHT_BITS];/* High time of each bit */
+} dht_frame_t;
+
+dht_status_t dht_decode(const gpio_edge_t *edges,unsigned n,dht_frame_t *frame);
+dht_status_t dht_decode_rule(const gpio_edge_t *edges,unsigned n,dht_frame_t *frame,const dht_rule_t *rule);
+int dht_rule_parse(const char *arg,dht_rule_t *rule);
+unsigned dht_sample_edges(const unsigned char *levels,unsigned n,unsigned long long t0,unsigned period_ns,int gpio,gpio_edge_t *edges,unsigned max);
+void dht_convert(const dht_frame_t *frame,dht_type_t type,int *rh10,int *temp10);
+void dht_encode(dht_type_t type,int rh10,int temp10,unsigned char bytes[5]);
+unsigned dht_synth(const unsigned char bytes[5],unsigned long long t0,int gpio,gpio_edge_t *edges);
+const char *dht_status_name(dht_status_t status);
+
+#endif /* DHT_DECODE_H */
+
+/*********************************************************************
+ * End dht_decode.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
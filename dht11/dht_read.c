@@ -0,0 +1,140 @@
+/*********************************************************************
+ * dht_read.c : Read DHT11/DHT22 sensors through kernel GPIO lines
+ *
+ * The line is turned around in place for the start pulse
+ * (gpio_line_direction()), so the edges of the reply are queued with
+ * kernel timestamps while we sleep.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "dht_read.h"
+
+/*
+ * Internal : Sleep until CLOCK_MONOTONIC time ns
+ */
+static void
+sleep_until(unsigned long long ns) {
+	struct timespec ts;
+
+	ts.tv_sec = ns / 1000000000ULL;
+	ts.tv_nsec = ns % 1000000000ULL;
+	while ( clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,0) == EINTR )
+		;
+}
+
+/*
+ * Internal : Simulated sensor, answering a line released at t0 with
+ * a slowly changing reading and a few microseconds of edge jitter
+ */
+static void
+sim_sensor(dht_sensor_t *sensor,unsigned long long t0) {
+	gpio_edge_t edges[DHT_MAX_EDGES];
+	unsigned char bytes[5];
+	unsigned n, x, r = ++sensor->sim_reads + sensor->gpio;
+
+	dht_encode(sensor->type,450 + r % 50,sensor->type == dht22 ? 215 + r % 7 : 210 + r % 3 * 10,bytes);
+	n = dht_synth(bytes,t0,sensor->gpio,edges);
+	for ( x=0; x<n; ++x )
+		gpio_line_sim_edge(sensor->line,edges[x].level,edges[x].ns + rand() % 5000);
+}
+
+/*********************************************************************
+ * Request the sensor's GPIO. Returns 0, or -1 (reported).
+ *********************************************************************/
+int
+dht_open(dht_sensor_t *sensor,int gpio,dht_type_t type) {
+	memset(sensor,0,sizeof *sensor);
+	sensor->gpio = gpio;
+	sensor->type = type;
+	if ( !(sensor->line = gpio_line_input(gpio,GPIO_EV_BOTH,0)) )
+		return -1;
+	sensor->simulated = !strcmp(gpio_line_backend(sensor->line),"sim");
+	if ( !strcmp(gpio_line_backend(sensor->line),"sysfs") )
+		fprintf(stderr,"GPIO %d: sysfs edges are timestamped on wakeup, too late for DHT bits\n",gpio);
+	return 0;
+}
+
+/*********************************************************************
+ * Release the line, leaving it an input
+ *********************************************************************/
+void
+dht_close(dht_sensor_t *sensor) {
+	gpio_line_close(sensor->line);
+	sensor->line = 0;
+}
+
+/*
+ * Internal : Collect edges into edges[n..] until want of them have
+ * arrived (the last one rising, if high), or the deadline passes.
+ * Returns the new n.
+ */
+static unsigned
+collect(dht_sensor_t *sensor,gpio_edge_t *edges,unsigned n,unsigned want,int high,unsigned long long deadline) {
+	int rc;
+
+	while ( n < DHT_MAX_EDGES && !(n >= want && (!high || edges[n-1].level)) ) {
+		rc = gpio_line_wait_until(sensor->line,edges+n,DHT_MAX_EDGES-n,deadline);
+		if ( rc > 0 )
+			n += rc;
+		else if ( !rc )
+			break;			/* Deadline */
+		else if ( errno != EINTR ) {
+			perror("gpio_line_wait_until()");
+			break;
+		}
+	}
+	return n;
+}
+
+/*********************************************************************
+ * Send the start pulse and decode the reply. Every phase ends by an
+ * absolute deadline, so a read takes at most the start pulse plus
+ * DHT_FRAME_MS, however the line misbehaves.
+ *********************************************************************/
+dht_status_t
+dht_read(dht_sensor_t *sensor,dht_frame_t *frame) {
+	gpio_edge_t edges[DHT_MAX_EDGES], stale[16];
+	unsigned long long t0;
+	unsigned n, x;
+
+	t0 = gpio_line_now();
+	for ( x=0; x<DHT_DRAIN_READS; ++x )	/* Edges since the last read */
+		if ( gpio_line_wait_until(sensor->line,stale,16,t0) < 16 )
+			break;
+
+	if ( gpio_line_direction(sensor->line,1,0) ) {	/* Start pulse */
+		perror("gpio_line_direction()");
+		return dht_no_response;
+	}
+	sleep_until(gpio_line_now() + (sensor->type == dht22 ? DHT22_START_US : DHT11_START_US) * 1000ULL);
+	gpio_line_direction(sensor->line,0,0);	/* The pull-up takes it high */
+	t0 = gpio_line_now();
+
+	if ( sensor->simulated )
+		sim_sensor(sensor,t0);
+
+	/* The sensor pulls low to answer, then sends its bits */
+	n = collect(sensor,edges,0,1,0,t0 + DHT_RESPONSE_US * 1000ULL);
+	if ( n > 0 )				/* Until released after the last bit */
+		n = collect(sensor,edges,n,DHT_FRAME_EDGES,1,t0 + DHT_FRAME_MS * 1000000ULL);
+	return dht_decode(edges,n,frame);
+}
+
+/*********************************************************************
+ * Rest a sensor needs between reads
+ *********************************************************************/
+unsigned
+dht_min_interval_ms(dht_type_t type) {
+	return type == dht22 ? 2000 : 1000;
+}
+
+/*********************************************************************
+ * End dht_read.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
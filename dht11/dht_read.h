@@ -0,0 +1,47 @@
+/*********************************************************************
+ * dht_read.h : Read DHT11/DHT22 sensors through kernel GPIO lines
+ *
+ * dht_read() sends the start pulse, sleeps while the reply's edges
+ * are queued by the kernel, and decodes them (dht_decode.h). Each
+ * phase waits on an absolute deadline (gpio_line_wait_until()): the
+ * sensor must answer within DHT_RESPONSE_US of the release and be
+ * done within DHT_FRAME_MS, so a read never takes longer than the
+ * start pulse plus DHT_FRAME_MS. A sensor must rest
+ * dht_min_interval_ms() between reads.
+ *
+ * With GPIO_BACKEND=sim each read is answered by a simulated sensor.
+ *********************************************************************/
+
+#ifndef DHT_READ_H
+#define DHT_READ_H
+
+#include "gpio_line.h"			/* Kernel GPIO lines (libgpio) */
+#include "dht_decode.h"			/* Frame decoding */
+
+#define DHT11_START_US	20000		/* Start pulse (at least 18 ms) */
+#define DHT22_START_US	1100		/* Start pulse (at least 1 ms) */
+#define DHT_RESPONSE_US	200		/* The sensor pulls low within this */
+#define DHT_FRAME_MS	10		/* The reply is over within this */
+#define DHT_FRAME_EDGES	84		/* Edges in a whole reply */
+#define DHT_DRAIN_READS	64		/* Bound on draining stale edges */
+
+typedef struct {
+	gpio_line_t	*line;		/* The sensor's data line */
+	int		gpio;		/* GPIO number */
+	dht_type_t	type;		/* DHT11 or DHT22 */
+	int		simulated;	/* Sim line: fake the sensor */
+	unsigned	sim_reads;	/* Simulated reads so far */
+} dht_sensor_t;
+
+int dht_open(dht_sensor_t *sensor,int gpio,dht_type_t type);
+void dht_close(dht_sensor_t *sensor);
+dht_status_t dht_read(dht_sensor_t *sensor,dht_frame_t *frame);
+unsigned dht_min_interval_ms(dht_type_t type);
+
+#endif /* DHT_READ_H */
+
+/*********************************************************************
+ * End dht_read.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
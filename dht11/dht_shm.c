@@ -0,0 +1,127 @@
+/*********************************************************************
+ * dht_shm.c : Latest DHT readings in POSIX shared memory
+ *********************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dht_shm.h"
+
+/*
+ * Internal : Map the segment open on fd
+ */
+static dht_shm_t *
+shm_map(int fd,int prot) {
+	void *map;
+
+	map = mmap(NULL,sizeof(dht_shm_t),prot,MAP_SHARED,fd,0);
+	close(fd);
+	if ( map == MAP_FAILED ) {
+		perror("mmap(dht shm)");
+		return 0;
+	}
+	return (dht_shm_t *) map;
+}
+
+/*********************************************************************
+ * Create (or reset) the segment for nsensors entries. Returns 0 on
+ * failure (reported).
+ *********************************************************************/
+dht_shm_t *
+dht_shm_create(const char *name,unsigned nsensors) {
+	dht_shm_t *shm;
+	int fd;
+
+	fd = shm_open(name,O_RDWR|O_CREAT,0644);
+	if ( fd < 0 ) {
+		perror(name);
+		return 0;
+	}
+	if ( ftruncate(fd,sizeof *shm) ) {
+		perror("ftruncate(dht shm)");
+		close(fd);
+		return 0;
+	}
+	if ( !(shm = shm_map(fd,PROT_READ|PROT_WRITE)) )
+		return 0;
+
+	__atomic_store_n(&shm->magic,0,__ATOMIC_RELEASE);
+	memset(shm->entry,0,sizeof shm->entry);
+	shm->nsensors = nsensors;
+	__atomic_store_n(&shm->magic,DHT_SHM_MAGIC,__ATOMIC_RELEASE);
+	return shm;
+}
+
+/*********************************************************************
+ * Map an existing segment read-only. Returns 0 on failure.
+ *********************************************************************/
+dht_shm_t *
+dht_shm_open(const char *name) {
+	dht_shm_t *shm;
+	int fd;
+
+	fd = shm_open(name,O_RDONLY,0);
+	if ( fd < 0 ) {
+		perror(name);
+		return 0;
+	}
+	if ( !(shm = shm_map(fd,PROT_READ)) )
+		return 0;
+	if ( __atomic_load_n(&shm->magic,__ATOMIC_ACQUIRE) != DHT_SHM_MAGIC ) {
+		fprintf(stderr,"%s: not a DHT segment (is dhtsched running?)\n",name);
+		dht_shm_close(shm);
+		return 0;
+	}
+	return shm;
+}
+
+/*********************************************************************
+ * Unmap the segment (the name stays until shm_unlink(3))
+ *********************************************************************/
+void
+dht_shm_close(dht_shm_t *shm) {
+	munmap(shm,sizeof *shm);
+}
+
+/*********************************************************************
+ * Writer: bracket updates to an entry
+ *********************************************************************/
+void
+dht_shm_begin(dht_entry_t *entry) {
+	__atomic_store_n(&entry->seq,entry->seq + 1,__ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void
+dht_shm_end(dht_entry_t *entry) {
+	__atomic_store_n(&entry->seq,entry->seq + 1,__ATOMIC_RELEASE);
+}
+
+/*********************************************************************
+ * Reader: take a consistent copy of an entry
+ *********************************************************************/
+void
+dht_shm_get(const dht_entry_t *entry,dht_entry_t *copy) {
+	unsigned seq;
+
+	for (;;) {
+		seq = __atomic_load_n(&entry->seq,__ATOMIC_ACQUIRE);
+		if ( seq & 1 )
+			continue;		/* Being written */
+		memcpy(copy,(const void *)entry,sizeof *copy);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if ( __atomic_load_n(&entry->seq,__ATOMIC_RELAXED) == seq )
+			break;
+	}
+	copy->seq = seq;
+}
+
+/*********************************************************************
+ * End dht_shm.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
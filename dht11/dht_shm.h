@@ -0,0 +1,52 @@
+/*********************************************************************
+ * dht_shm.h : Latest DHT readings in POSIX shared memory
+ *
+ * dhtsched publishes one entry per sensor in a shm_open(3) segment
+ * (default "/dht"). Each entry is guarded by a sequence count: the
+ * writer makes it odd while updating, so readers simply copy the
+ * entry and retry if the count was odd or changed. Readers never
+ * block the scheduler. Each entry carries the sensor's statistics
+ * (dht_stats.h), which dhtsched -S reports.
+ *********************************************************************/
+
+#ifndef DHT_SHM_H
+#define DHT_SHM_H
+
+#include "dht_decode.h"
+#include "dht_stats.h"
+
+#define DHT_SHM_NAME	"/dht"		/* Default segment name */
+#define DHT_SHM_MAGIC	0x44485432	/* "DHT2" */
+#define DHT_MAX_SENSORS	32		/* Entries in a segment */
+
+typedef struct {
+	unsigned	seq;		/* Odd while being written */
+	int		gpio;		/* GPIO number */
+	dht_type_t	type;		/* DHT11 or DHT22 */
+	dht_status_t	status;		/* Status of the last read */
+	int		rh10;		/* Last good RH in tenths of % */
+	int		temp10;		/* Last good temp in tenths of C */
+	unsigned long long ns;		/* CLOCK_MONOTONIC of last good read */
+	dht_stats_t	stats;		/* Error counts and bit widths */
+} dht_entry_t;
+
+typedef struct {
+	unsigned	magic;		/* DHT_SHM_MAGIC once set up */
+	unsigned	nsensors;	/* Entries in use */
+	dht_entry_t	entry[DHT_MAX_SENSORS];
+} dht_shm_t;
+
+dht_shm_t *dht_shm_create(const char *name,unsigned nsensors);
+dht_shm_t *dht_shm_open(const char *name);
+void dht_shm_close(dht_shm_t *shm);
+void dht_shm_begin(dht_entry_t *entry);
+void dht_shm_end(dht_entry_t *entry);
+void dht_shm_get(const dht_entry_t *entry,dht_entry_t *copy);
+
+#endif /* DHT_SHM_H */
+
+/*********************************************************************
+ * End dht_shm.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
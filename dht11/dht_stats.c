@@ -0,0 +1,124 @@
+/*********************************************************************
+ * dht_stats.c : Per-sensor DHT error counts and bit-width histograms
+ *********************************************************************/
+
+#include <string.h>
+
+#include "dht_stats.h"
+#include "dht_read.h"			/* dht_min_interval_ms() */
+
+#define BAR_WIDTH	40		/* Widest histogram bar */
+
+/*********************************************************************
+ * Clear the counters
+ *********************************************************************/
+void
+dht_stats_init(dht_stats_t *stats) {
+	memset(stats,0,sizeof *stats);
+	stats->last = dht_no_response;
+	stats->zero_min = stats->one_min = ~0u;
+}
+
+/*
+ * Internal : Histogram bin for us microseconds
+ */
+static unsigned
+bin(unsigned us) {
+	us /= DHT_HIST_US;
+	return us < DHT_HIST_BINS ? us : DHT_HIST_BINS - 1;
+}
+
+/*********************************************************************
+ * Account for one read
+ *********************************************************************/
+void
+dht_stats_add(dht_stats_t *stats,dht_status_t status,const dht_frame_t *frame) {
+	unsigned b, hi;
+
+	if ( (unsigned)status < DHT_NSTATUS )
+		++stats->count[status];
+	stats->failures = status == dht_ok ? 0 : stats->failures + 1;
+	stats->last = status;
+
+	if ( status != dht_ok && status != dht_checksum && status != dht_bit_width )
+		return;				/* No whole frame */
+
+	for ( b=0; b<DHT_BITS; ++b ) {
+		hi = frame->hi_us[b];
+		++stats->hi_hist[bin(hi)];
+		++stats->lo_hist[bin(frame->lo_us[b])];
+		if ( hi > DHT_ONE_US ) {
+			if ( hi < stats->one_min )
+				stats->one_min = hi;
+			if ( hi > stats->one_max )
+				stats->one_max = hi;
+		} else	{
+			if ( hi < stats->zero_min )
+				stats->zero_min = hi;
+			if ( hi > stats->zero_max )
+				stats->zero_max = hi;
+		}
+	}
+}
+
+/*********************************************************************
+ * Milliseconds to wait before reading again after a failed read
+ *********************************************************************/
+unsigned
+dht_retry_ms(const dht_stats_t *stats,dht_type_t type,unsigned interval_ms) {
+	unsigned ms = dht_min_interval_ms(type), cap, x;
+
+	if ( stats->last != dht_no_response )
+		return ms;			/* It answered: try again soon */
+
+	cap = interval_ms > DHT_RETRY_MAX_MS ? interval_ms : DHT_RETRY_MAX_MS;
+	for ( x=1; x<stats->failures && ms < cap; ++x )
+		ms *= 2;
+	return ms < cap ? ms : cap;
+}
+
+/*********************************************************************
+ * Report the counters, margins and histograms
+ *********************************************************************/
+void
+dht_stats_print(FILE *out,const dht_stats_t *stats) {
+	unsigned x, peak = 1, n;
+	int s;
+
+	for ( s=0; s<DHT_NSTATUS; ++s )
+		fprintf(out,"%s%s %u",s ? ", " : "Reads: ",dht_status_name((dht_status_t)s),stats->count[s]);
+	fputc('\n',out);
+
+	if ( stats->zero_min != ~0u )
+		fprintf(out,"0 bits: %u..%u us high, margin %d us\n",
+			stats->zero_min,stats->zero_max,DHT_ZERO_MAX_US - (int)stats->zero_max);
+	if ( stats->one_min != ~0u )
+		fprintf(out,"1 bits: %u..%u us high, margin %d us\n",
+			stats->one_min,stats->one_max,(int)stats->one_min - DHT_ONE_MIN_US);
+
+	for ( x=0; x<DHT_HIST_BINS; ++x ) {
+		if ( stats->hi_hist[x] > peak )
+			peak = stats->hi_hist[x];
+		if ( stats->lo_hist[x] > peak )
+			peak = stats->lo_hist[x];
+	}
+
+	fprintf(out,"    us     high      low\n");
+	for ( x=0; x<DHT_HIST_BINS; ++x ) {
+		if ( !stats->hi_hist[x] && !stats->lo_hist[x] )
+			continue;
+		fprintf(out,"%3u%s %8u %8u ",x * DHT_HIST_US,x == DHT_HIST_BINS-1 ? "+ " : "  ",
+			stats->hi_hist[x],stats->lo_hist[x]);
+		for ( n = (stats->hi_hist[x] * BAR_WIDTH + peak - 1) / peak; n > 0; --n )
+			fputc('H',out);
+		for ( n = (stats->lo_hist[x] * BAR_WIDTH + peak - 1) / peak; n > 0; --n )
+			fputc('L',out);
+		fputc('\n',out);
+	}
+}
+
+/*********************************************************************
+ * End dht_stats.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
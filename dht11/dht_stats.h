@@ -0,0 +1,50 @@
+/*********************************************************************
+ * dht_stats.h : Per-sensor DHT error counts and bit-width histograms
+ *
+ * Every read is counted by its status. Frames that arrived whole
+ * (ok, checksum or bit width) also add their 40 low and high times
+ * to the histograms, and the 0 and 1 high times closest to the
+ * guard band are kept: when those margins shrink, the timing is
+ * degrading (long wires, a weak pull-up or interrupt latency) before
+ * reads start to fail.
+ *
+ * dht_retry_ms() spaces the reads after a failure: a garbled frame
+ * is retried as soon as the sensor allows, a silent sensor is backed
+ * off exponentially up to DHT_RETRY_MAX_MS.
+ *********************************************************************/
+
+#ifndef DHT_STATS_H
+#define DHT_STATS_H
+
+#include <stdio.h>
+
+#include "dht_decode.h"
+
+#define DHT_HIST_US	2		/* Microseconds per histogram bin */
+#define DHT_HIST_BINS	64		/* Last bin holds the overflow */
+#define DHT_RETRY_MAX_MS 30000		/* Longest backoff for a silent sensor */
+
+typedef struct {
+	unsigned	count[DHT_NSTATUS];	/* Reads by status */
+	unsigned	failures;	/* Consecutive failed reads */
+	dht_status_t	last;		/* Status of the last read */
+	unsigned	zero_min;	/* Shortest 0 high time (us) */
+	unsigned	zero_max;	/* Longest 0 high time */
+	unsigned	one_min;	/* Shortest 1 high time */
+	unsigned	one_max;	/* Longest 1 high time */
+	unsigned	hi_hist[DHT_HIST_BINS];	/* High times */
+	unsigned	lo_hist[DHT_HIST_BINS];	/* Low times */
+} dht_stats_t;
+
+void dht_stats_init(dht_stats_t *stats);
+void dht_stats_add(dht_stats_t *stats,dht_status_t status,const dht_frame_t *frame);
+unsigned dht_retry_ms(const dht_stats_t *stats,dht_type_t type,unsigned interval_ms);
+void dht_stats_print(FILE *out,const dht_stats_t *stats);
+
+#endif /* DHT_STATS_H */
+
+/*********************************************************************
+ * End dht_stats.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,225 @@
+/*********************************************************************
+ * dhtbench.c : DHT decode accuracy against timing noise
+ *
+ * ./dhtbench [-n frames] [-j max_jitter_us] [-k skew_pct] [-p sample_us]
+ *	[-s seed] [-t 11|22] [-w corpus.edg] [-r rule] ...
+ *
+ * Synthesizes random frames (dht_synth()), stretches each by a
+ * random clock skew of up to skew_pct (a DHT11's RC oscillator
+ * wanders), adds Gaussian jitter to every edge, optionally samples
+ * the line every sample_us as register polling would, and decodes
+ * them with each rule (see dhtdecode.c for the syntax). For each
+ * jitter level it reports the frames decoded correctly, rejected
+ * (checksum or bit width) and, worst, accepted with wrong data,
+ * plus the decode time. -w saves the corpus as an edge recording
+ * for dhtdecode.
+ *
+ * The default rules compare the fixed threshold, with and without
+ * its guard band, against the old counting loop's lo/3 bias (67%).
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include "edge_rec.h"			/* Edge recordings (libgpio) */
+#include "dht_decode.h"
+
+#define MAX_RULES	8
+#define STEPS		10		/* Jitter levels after 0 */
+#define FRAME_GAP_NS	10000000ULL	/* Frame spacing in the corpus */
+
+typedef struct {
+	const char	*name;		/* As given to -r */
+	dht_rule_t	rule;
+	unsigned	ok;		/* Correct */
+	unsigned	rejected;	/* Not dht_ok */
+	unsigned	wrong;		/* dht_ok with wrong bytes */
+	double		ns;		/* Time spent decoding */
+} bench_t;
+
+static const char *default_rules[] = { "48,8", "48", "67%", "67%,8" };
+
+/*
+ * Gaussian random number, mean 0 and standard deviation sigma :
+ */
+static double
+gauss(double sigma) {
+	double u = drand48(), v = drand48();
+
+	return sigma * sqrt(-2.0 * log(u > 0 ? u : 1e-12)) * cos(2 * M_PI * v);
+}
+
+static double
+now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Noisy edges of a frame released at t0. Returns the edge count.
+ */
+static unsigned
+noisy_frame(const unsigned char bytes[5],unsigned long long t0,double skew,double jitter_us,unsigned sample_us,gpio_edge_t *edges) {
+	gpio_edge_t ideal[DHT_MAX_EDGES];
+	static unsigned char *levels = 0;
+	unsigned long long t, prev = t0;
+	unsigned n, x, ns, e;
+
+	n = dht_synth(bytes,t0,0,ideal);
+	for ( x=0; x<n; ++x ) {
+		t = t0 + (unsigned long long)((ideal[x].ns - t0) * skew + gauss(jitter_us * 1000.0));
+		if ( t <= prev )
+			t = prev + 1000;	/* Keep them in order */
+		ideal[x].ns = prev = t;
+	}
+	if ( !sample_us ) {
+		memcpy(edges,ideal,n * sizeof *edges);
+		return n;
+	}
+
+	/* Sample the line, high before the frame */
+	ns = (ideal[n-1].ns - t0) / (sample_us * 1000ULL) + 2;
+	if ( !levels )
+		levels = malloc(1 << 20);
+	if ( ns > 1 << 20 )
+		ns = 1 << 20;
+	for ( x=0, e=0; x<ns; ++x ) {
+		t = t0 + (unsigned long long)x * sample_us * 1000;
+		while ( e < n && ideal[e].ns <= t )
+			++e;
+		levels[x] = e ? ideal[e-1].level : 1;
+	}
+	return dht_sample_edges(levels,ns,t0,sample_us * 1000,0,edges,DHT_MAX_EDGES);
+}
+
+int
+main(int argc,char **argv) {
+	bench_t bench[MAX_RULES] = {{0}};
+	unsigned nrules = 0, nframes = 2000, sample_us = 0, step, f, r, n;
+	double max_jitter = 20.0, skew_pct = 15.0, jitter, t;
+	dht_type_t type = dht11;
+	const char *corpus = 0;
+	edge_rec_t *rec = 0;
+	unsigned long long t0 = 1000000000ULL;
+	unsigned char bytes[5];
+	gpio_edge_t edges[DHT_MAX_EDGES];
+	dht_frame_t frame;
+	dht_status_t status;
+	long seed = 1;
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"n:j:k:p:s:t:w:r:h")) != EOF )
+		switch ( optch ) {
+		case 'n' :
+			nframes = strtoul(optarg,0,10);
+			break;
+		case 'j' :
+			max_jitter = atof(optarg);
+			break;
+		case 'k' :
+			skew_pct = atof(optarg);
+			break;
+		case 'p' :
+			sample_us = strtoul(optarg,0,10);
+			break;
+		case 's' :
+			seed = atol(optarg);
+			break;
+		case 't' :
+			if ( !strcmp(optarg,"22") || !strcmp(optarg,"2302") )
+				type = dht22;
+			else if ( strcmp(optarg,"11") )
+				goto usage;
+			break;
+		case 'w' :
+			corpus = optarg;
+			break;
+		case 'r' :
+			if ( nrules >= MAX_RULES || dht_rule_parse(optarg,&bench[nrules].rule) )
+				goto usage;
+			bench[nrules++].name = optarg;
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,
+				"Usage: %s [-n frames] [-j max_jitter_us] [-k skew_pct] [-p sample_us]\n"
+				"\t[-s seed] [-t 11|22] [-w corpus.edg] [-r us|pct%%[,guard_us]] ...\n",
+				argv[0]);
+			exit(1);
+		}
+
+	if ( !nrules )
+		for ( ; nrules < sizeof default_rules / sizeof default_rules[0]; ++nrules ) {
+			bench[nrules].name = default_rules[nrules];
+			dht_rule_parse(default_rules[nrules],&bench[nrules].rule);
+		}
+
+	if ( corpus && !(rec = edge_rec_open(corpus)) )
+		exit(2);
+
+	printf("%u frames per level, skew +/-%.0f%%, %s\n\n",nframes,skew_pct,
+		sample_us ? "sampled" : "edge timestamps");
+	printf("jitter");
+	for ( r=0; r<nrules; ++r )
+		printf(" | %-22s",bench[r].name);
+	printf("\n    us");
+	for ( r=0; r<nrules; ++r )
+		printf(" | %6s %6s %6s ","ok%","rej%","wrong%");
+	putchar('\n');
+
+	srand48(seed);
+	for ( step=0; step<=STEPS; ++step ) {
+		jitter = max_jitter * step / STEPS;
+		for ( r=0; r<nrules; ++r )
+			bench[r].ok = bench[r].rejected = bench[r].wrong = 0;
+
+		for ( f=0; f<nframes; ++f ) {
+			if ( type == dht22 )
+				dht_encode(type,lrand48() % 1000,lrand48() % 1200 - 400,bytes);
+			else	dht_encode(type,(20 + lrand48() % 71) * 10,(lrand48() % 51) * 10,bytes);
+			n = noisy_frame(bytes,t0,1.0 + (drand48() * 2 - 1) * skew_pct / 100,jitter,sample_us,edges);
+
+			while ( rec && edge_rec_put(rec,edges,n) < n )
+				usleep(1000);	/* Let the writer catch up */
+			t0 += FRAME_GAP_NS;
+
+			for ( r=0; r<nrules; ++r ) {
+				t = now_ns();
+				status = dht_decode_rule(edges,n,&frame,&bench[r].rule);
+				bench[r].ns += now_ns() - t;
+				if ( status != dht_ok )
+					++bench[r].rejected;
+				else if ( memcmp(frame.bytes,bytes,5) )
+					++bench[r].wrong;
+				else	++bench[r].ok;
+			}
+		}
+
+		printf("%6.1f",jitter);
+		for ( r=0; r<nrules; ++r )
+			printf(" | %6.2f %6.2f %6.2f ",100.0 * bench[r].ok / nframes,
+				100.0 * bench[r].rejected / nframes,100.0 * bench[r].wrong / nframes);
+		putchar('\n');
+	}
+
+	printf("\ndecode ns/frame");
+	for ( r=0; r<nrules; ++r )
+		printf("  %s: %.0f",bench[r].name,bench[r].ns / (nframes * (STEPS + 1.0)));
+	putchar('\n');
+
+	if ( rec )
+		printf("%llu edges written to %s\n",edge_rec_close(rec),corpus);
+	return 0;
+}
+
+/*********************************************************************
+ * End dhtbench.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
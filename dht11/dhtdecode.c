@@ -0,0 +1,151 @@
+/*********************************************************************
+ * dhtdecode.c : Decode DHT11/DHT22 frames from a recording
+ *
+ * ./dhtdecode [-t 11|22] [-r rule] [-v] file.edg
+ * ./dhtdecode [-t 11|22] [-r rule] [-v] -p period_us samples.txt
+ *
+ * The recording is either an edge recording (edge_rec.h, as made by
+ * evinput -w or dhtbench -w), or level samples taken every period_us
+ * written as 0 and 1 characters (anything else is ignored), as a
+ * logic analyser exports them. Frames are split at gaps longer than
+ * SPLIT_US and decoded by the same code as a live read, so a capture
+ * of a misbehaving sensor can be studied at a desk.
+ *
+ * The rule is the fixed threshold in microseconds ("48"), or the
+ * percentage of each bit's low time ("67%"), optionally followed by
+ * a guard band (",8"). The default is dht_default_rule.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "edge_rec.h"			/* Edge recordings (libgpio) */
+#include "dht_decode.h"
+
+#define SPLIT_US	1000		/* Gap between frames */
+#define MAX_EDGES	(DHT_MAX_EDGES * 4)
+
+static dht_type_t dht_type = dht11;	/* -t */
+static dht_rule_t rule;			/* -r */
+static int verbose = 0;			/* -v */
+static unsigned frames = 0, good = 0;
+
+/*
+ * Decode and report one frame's edges :
+ */
+static void
+frame_out(const gpio_edge_t *edges,unsigned n) {
+	dht_frame_t frame;
+	dht_status_t status;
+	int rh10, temp10;
+	unsigned b;
+
+	if ( n < 3 )
+		return;				/* Start pulse, idle line */
+
+	status = dht_decode_rule(edges,n,&frame,&rule);
+	++frames;
+	printf("%12.6f ",edges[0].ns / 1e9);
+	if ( status == dht_ok ) {
+		++good;
+		dht_convert(&frame,dht_type,&rh10,&temp10);
+		printf("RH %.1f%% Temp %.1f C\n",rh10/10.0,temp10/10.0);
+	} else	printf("%s (%u edges)\n",dht_status_name(status),n);
+
+	if ( verbose && status != dht_no_response && status != dht_short_frame ) {
+		for ( b=0; b<DHT_BITS; ++b )
+			printf("%s%u/%u",b % 8 ? " " : b ? "\n\t" : "\t",frame.lo_us[b],frame.hi_us[b]);
+		putchar('\n');
+	}
+}
+
+/*
+ * Split a stream of edges into frames :
+ */
+static void
+split(gpio_edge_t *edges,unsigned *n,const gpio_edge_t *edge) {
+
+	if ( *n > 0 && (edge->ns - edges[*n-1].ns > SPLIT_US * 1000ULL || *n >= MAX_EDGES) ) {
+		frame_out(edges,*n);
+		*n = 0;
+	}
+	edges[(*n)++] = *edge;
+}
+
+int
+main(int argc,char **argv) {
+	gpio_edge_t edges[MAX_EDGES], edge;
+	unsigned period_us = 0, n = 0;
+	unsigned long long x = 0;
+	int optch, ch, level = -1;
+	FILE *f;
+
+	rule = dht_default_rule;
+
+	while ( (optch = getopt(argc,argv,"t:r:p:vh")) != EOF )
+		switch ( optch ) {
+		case 't' :
+			if ( !strcmp(optarg,"22") || !strcmp(optarg,"2302") )
+				dht_type = dht22;
+			else if ( strcmp(optarg,"11") )
+				goto usage;
+			break;
+		case 'r' :
+			if ( dht_rule_parse(optarg,&rule) )
+				goto usage;
+			break;
+		case 'p' :
+			period_us = strtoul(optarg,0,10);
+			break;
+		case 'v' :
+			verbose = 1;
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,
+				"Usage: %s [-t 11|22] [-r us|pct%%[,guard_us]] [-v] file.edg\n"
+				"       %s [-t 11|22] [-r us|pct%%[,guard_us]] [-v] -p period_us samples.txt\n",
+				argv[0],argv[0]);
+			exit(1);
+		}
+
+	if ( optind + 1 != argc )
+		goto usage;
+
+	if ( !period_us ) {
+		if ( !(f = edge_rec_fopen(argv[optind])) )
+			exit(2);
+		while ( edge_rec_read(f,&edge) )
+			split(edges,&n,&edge);
+	} else	{
+		if ( !(f = fopen(argv[optind],"r")) ) {
+			perror(argv[optind]);
+			exit(2);
+		}
+		edge.gpio = 0;
+		while ( (ch = fgetc(f)) != EOF ) {
+			if ( ch != '0' && ch != '1' )
+				continue;
+			if ( ch - '0' != level && level >= 0 ) {
+				edge.ns = x * period_us * 1000ULL;
+				edge.level = ch - '0';
+				split(edges,&n,&edge);
+			}
+			level = ch - '0';
+			++x;
+		}
+	}
+	fclose(f);
+	frame_out(edges,n);
+
+	printf("%u frames, %u good\n",frames,good);
+	return 0;
+}
+
+/*********************************************************************
+ * End dhtdecode.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
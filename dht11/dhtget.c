@@ -0,0 +1,65 @@
+/*********************************************************************
+ * dhtget.c : Print DHT readings cached by dhtsched
+ *
+ * ./dhtget [-u path] [-a max_age_ms] gpio ...
+ *
+ * Each reading is at most max_age_ms old (default 10000): dhtsched
+ * answers from its cache, or reads the sensor first when the cached
+ * reading is too old (see dht_client.h).
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "dht_client.h"
+
+int
+main(int argc,char **argv) {
+	const char *path = DHT_SOCKET;
+	unsigned max_age = 10000;
+	dht_reading_t r;
+	int optch, rc = 0;
+
+	while ( (optch = getopt(argc,argv,"u:a:h")) != EOF )
+		switch ( optch ) {
+		case 'u' :
+			path = optarg;
+			break;
+		case 'a' :
+			max_age = strtoul(optarg,0,10);
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,"Usage: %s [-u path] [-a max_age_ms] gpio ...\n",argv[0]);
+			exit(1);
+		}
+
+	if ( optind >= argc )
+		goto usage;
+
+	for ( ; optind < argc; ++optind ) {
+		if ( dht_query(path,atoi(argv[optind]),max_age,&r) ) {
+			fprintf(stderr,"GPIO %s: %s\n",argv[optind],strerror(errno));
+			rc = 2;
+		} else if ( r.age_ms < 0 ) {
+			printf("GPIO %d: no reading (%s)\n",r.gpio,dht_status_name(r.status));
+			rc = 2;
+		} else	{
+			printf("GPIO %d: RH %.1f%% Temp %.1f C, %.1f s old",
+				r.gpio,r.rh10/10.0,r.temp10/10.0,r.age_ms/1000.0);
+			if ( r.status != dht_ok )
+				printf(" (last read: %s)",dht_status_name(r.status));
+			putchar('\n');
+		}
+	}
+	return rc;
+}
+
+/*********************************************************************
+ * End dhtget.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
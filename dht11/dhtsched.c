@@ -0,0 +1,483 @@
+/*********************************************************************
+ * dhtsched.c : Poll many DHT11/DHT22 sensors from one thread
+ *
+ * ./dhtsched [-s shmname] [-u path] [-i ms] [-R cpu[,prio]] [-v] gpio[:22] ...
+ * ./dhtsched [-s shmname] -l|-S
+ *
+ * Each argument names a sensor's GPIO, optionally followed by :22
+ * for a DHT22 (:11 is the default). Only one capture is ever in
+ * progress, so all of them can share the one real-time core given
+ * with -R. Start times are staggered evenly over the interval and a
+ * sensor is never read sooner than its minimum interval after its
+ * last start pulse; a read that is held up by another simply runs
+ * late. After a failed read the next one is spaced by dht_retry_ms().
+ * The latest reading of each sensor is published in shared memory
+ * (dht_shm.h) with its statistics: -l lists the readings, -S the
+ * error counts and bit-width histograms. dhtsched is setuid root,
+ * so the shared memory (and socket) names are created and removed
+ * with the real user's rights.
+ *
+ * With -u the readings are also served on a Unix socket (see
+ * dht_client.h and dhtget.c). A client asking for a reading younger
+ * than the cached one moves that sensor's next read forward, as far
+ * as its minimum interval allows, and is answered when it completes.
+ * Clients are served between captures, by the same thread.
+ *********************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "rt_setup.h"			/* rt_optarg() (libgpio) */
+#include "user_file.h"			/* user_begin() (libgpio) */
+#include "dht_read.h"			/* dht_read() */
+#include "dht_shm.h"			/* Published readings */
+#include "dht_client.h"			/* Socket protocol */
+
+#define MAX_CLIENTS	64		/* Open client connections */
+
+typedef struct {
+	dht_sensor_t	sensor;		/* Open sensor */
+	unsigned long long interval;	/* ns between reads */
+	unsigned long long due;		/* When the next read is due */
+	unsigned long long started;	/* Start of the last read */
+} sched_t;
+
+typedef struct {
+	int		fd;		/* Connection, or -1 if free */
+	int		sensor;		/* Awaited sensor, or -1 for request */
+	unsigned	len;		/* Bytes in buf */
+	char		buf[DHT_LINE_MAX];	/* Request line */
+} client_t;
+
+static volatile int is_signaled = 0;	/* Exit program if signaled */
+static sched_t sched[DHT_MAX_SENSORS];	/* Sensors */
+static unsigned nsensors = 0;
+static dht_shm_t *shm = 0;		/* Published readings */
+static client_t clients[MAX_CLIENTS];
+static int rescheduled = 0;		/* A request moved a read forward */
+
+static void
+sig_handler(int signo) {
+	is_signaled = 1;
+}
+
+/*
+ * Remove a stale socket, but never anything else :
+ */
+static void
+unlink_socket(const char *path) {
+	struct stat st;
+
+	if ( !lstat(path,&st) && S_ISSOCK(st.st_mode) )
+		unlink(path);
+}
+
+/*
+ * Open the listening socket at path (as the real user) :
+ */
+static int
+serve(const char *path) {
+	struct sockaddr_un addr;
+	uid_t euid;
+	int fd;
+
+	memset(&addr,0,sizeof addr);
+	if ( strlen(path) >= sizeof addr.sun_path ) {
+		fprintf(stderr,"%s: socket path too long\n",path);
+		exit(2);
+	}
+	if ( (fd = socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK,0)) < 0 ) {
+		perror("socket()");
+		exit(2);
+	}
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path,path);
+
+	euid = user_begin();
+	unlink_socket(path);
+	if ( bind(fd,(struct sockaddr *)&addr,sizeof addr) || listen(fd,16) ) {
+		perror(path);
+		exit(2);
+	}
+	chmod(path,0666);			/* Any user may query */
+	user_end(euid);
+	return fd;
+}
+
+/*
+ * Answer a client with sensor n's cached reading, and hang up :
+ */
+static void
+answer(client_t *client,int n) {
+	unsigned long long now = gpio_line_now();
+	char buf[DHT_LINE_MAX];
+	dht_entry_t *e;
+	int len;
+
+	if ( n < 0 )
+		len = snprintf(buf,sizeof buf,"%d -1 0 0 -1\n",client->sensor);
+	else	{
+		e = &shm->entry[n];
+		len = snprintf(buf,sizeof buf,"%d %d %d %d %ld\n",e->gpio,(int)e->status,e->rh10,e->temp10,
+			e->stats.count[dht_ok] ? (long)((now - e->ns) / 1000000) : -1L);
+	}
+	send(client->fd,buf,len,MSG_NOSIGNAL|MSG_DONTWAIT);
+	close(client->fd);
+	client->fd = -1;
+}
+
+/*
+ * Take a request, answering it now when the cache is fresh enough :
+ */
+static void
+request(client_t *client) {
+	unsigned long long now, soonest;
+	unsigned max_age, x;
+	dht_entry_t *e;
+	sched_t *s;
+	int n, gpio;
+
+	n = read(client->fd,client->buf+client->len,sizeof client->buf - 1 - client->len);
+	if ( n <= 0 ) {
+		if ( n < 0 && errno == EAGAIN )
+			return;
+		close(client->fd);		/* Hung up */
+		client->fd = -1;
+		return;
+	}
+	client->len += n;
+	client->buf[client->len] = 0;
+	if ( !strchr(client->buf,'\n') ) {
+		if ( client->len >= sizeof client->buf - 1 ) {
+			close(client->fd);	/* No request line */
+			client->fd = -1;
+		}
+		return;
+	}
+
+	if ( sscanf(client->buf,"%d %u",&gpio,&max_age) != 2 ) {
+		close(client->fd);
+		client->fd = -1;
+		return;
+	}
+
+	for ( x=0; x<nsensors && sched[x].sensor.gpio != gpio; ++x )
+		;
+	if ( x >= nsensors ) {
+		client->sensor = gpio;		/* Report it unknown */
+		answer(client,-1);
+		return;
+	}
+
+	now = gpio_line_now();
+	e = &shm->entry[x];
+	if ( e->stats.count[dht_ok] && now - e->ns <= max_age * 1000000ULL ) {
+		answer(client,x);		/* Fresh enough */
+		return;
+	}
+
+	/*
+	 * Wait for a new read, as soon as the sensor allows
+	 */
+	client->sensor = x;
+	s = &sched[x];
+	soonest = s->started ? s->started + dht_min_interval_ms(s->sensor.type) * 1000000ULL : now;
+	if ( soonest < now )
+		soonest = now;
+	if ( soonest < s->due ) {
+		s->due = soonest;
+		rescheduled = 1;
+	}
+}
+
+/*
+ * Serve clients until CLOCK_MONOTONIC time ns (or a signal) :
+ */
+static void
+serve_until(int lfd,unsigned long long ns) {
+	struct pollfd pfd[MAX_CLIENTS+1];
+	client_t *ix[MAX_CLIENTS+1];
+	unsigned long long now;
+	struct timespec ts;
+	int n, x, fd;
+
+	rescheduled = 0;
+	while ( !is_signaled && !rescheduled && (now = gpio_line_now()) < ns ) {
+		ts.tv_sec = (ns - now) / 1000000000ULL;
+		ts.tv_nsec = (ns - now) % 1000000000ULL;
+		if ( lfd < 0 ) {
+			clock_nanosleep(CLOCK_MONOTONIC,0,&ts,0);
+			continue;
+		}
+
+		pfd[0].fd = lfd;
+		pfd[0].events = POLLIN;
+		for ( n=1, x=0; x<MAX_CLIENTS; ++x )
+			if ( clients[x].fd >= 0 && clients[x].sensor < 0 ) {
+				pfd[n].fd = clients[x].fd;
+				pfd[n].events = POLLIN;
+				ix[n++] = &clients[x];
+			}
+		if ( ppoll(pfd,n,&ts,0) <= 0 )
+			continue;
+
+		for ( x=1; x<n; ++x )
+			if ( pfd[x].revents )
+				request(ix[x]);
+
+		if ( pfd[0].revents & POLLIN ) {
+			while ( (fd = accept4(lfd,0,0,SOCK_NONBLOCK|SOCK_CLOEXEC)) >= 0 ) {
+				for ( x=0; x<MAX_CLIENTS && clients[x].fd >= 0; ++x )
+					;
+				if ( x >= MAX_CLIENTS ) {
+					close(fd);	/* Too many */
+					continue;
+				}
+				clients[x].fd = fd;
+				clients[x].sensor = -1;
+				clients[x].len = 0;
+			}
+		}
+	}
+}
+
+/*
+ * List the published readings :
+ */
+static int
+list(const char *name,int stats) {
+	unsigned long long now = gpio_line_now();
+	dht_shm_t *shm;
+	dht_entry_t e;
+	unsigned x, y, ok, errs;
+
+	if ( !(shm = dht_shm_open(name)) )
+		return 1;
+
+	if ( !stats )
+		printf("GPIO Type     RH%%   Temp C    Age s  Readings  Errors  Last\n");
+	for ( x=0; x<shm->nsensors && x<DHT_MAX_SENSORS; ++x ) {
+		dht_shm_get(&shm->entry[x],&e);
+		ok = e.stats.count[dht_ok];
+		if ( stats ) {
+			printf("%sGPIO %d DHT%d:\n",x ? "\n" : "",e.gpio,e.type == dht22 ? 22 : 11);
+			dht_stats_print(stdout,&e.stats);
+			continue;
+		}
+		printf("%4d DHT%d ",e.gpio,e.type == dht22 ? 22 : 11);
+		if ( ok > 0 )
+			printf("%6.1f %8.1f %8.1f",e.rh10/10.0,e.temp10/10.0,(now - e.ns) / 1e9);
+		else	printf("%6s %8s %8s","-","-","-");
+		for ( errs=0, y=dht_ok+1; y<DHT_NSTATUS; ++y )
+			errs += e.stats.count[y];
+		printf(" %9u %7u  %s\n",ok,errs,dht_status_name(e.status));
+	}
+	dht_shm_close(shm);
+	return 0;
+}
+
+/*
+ * Main program :
+ */
+int
+main(int argc,char **argv) {
+	const char *shm_name = DHT_SHM_NAME, *sock_path = 0;
+	unsigned interval_ms = 0, min_ms;
+	int optch, verbose = 0, listing = 0, lfd = -1;
+	uid_t euid;
+	unsigned long long now, t0, stagger;
+	sched_t *s;
+	unsigned n, x;
+	unsigned long long interval;
+	dht_entry_t *e;
+	dht_frame_t frame;
+	dht_status_t status;
+	dht_type_t type;
+	char *cp;
+	int rh10, temp10;
+
+	while ( (optch = getopt(argc,argv,"s:u:i:R:lSvh")) != EOF )
+		switch ( optch ) {
+		case 's' :
+			shm_name = optarg;
+			break;
+		case 'u' :
+			sock_path = optarg;
+			break;
+		case 'i' :
+			interval_ms = strtoul(optarg,0,10);
+			break;
+		case 'R' :
+			rt_optarg(optarg);	/* Real-time CPU[,priority] */
+			break;
+		case 'l' :
+			listing = 1;
+			break;
+		case 'S' :
+			listing = 2;
+			break;
+		case 'v' :
+			verbose = 1;
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,
+				"Usage: %s [-s shmname] [-u path] [-i ms] [-R cpu[,priority]] [-v] gpio[:11|:22] ...\n"
+				"       %s [-s shmname] -l|-S\n"
+				"where:\n"
+				"\t-s name\tshared memory name (default %s)\n"
+				"\t-u path\tserve readings on a Unix socket (e.g. %s)\n"
+				"\t-i ms\tread interval (default: each sensor's minimum)\n"
+				"\t-R cpu,prio\tpin to a CPU with SCHED_FIFO\n"
+				"\t-v\tprint each reading\n"
+				"\t-l\tlist the readings published by a running %s\n"
+				"\t-S\treport its error counts and bit-width histograms\n",
+				argv[0],argv[0],DHT_SHM_NAME,DHT_SOCKET,argv[0]);
+			exit(1);
+		}
+
+	if ( listing ) {
+		user_begin();			/* Root is not needed again */
+		return list(shm_name,listing == 2);
+	}
+
+	if ( optind >= argc )
+		goto usage;
+	if ( argc - optind > DHT_MAX_SENSORS ) {
+		fprintf(stderr,"At most %d sensors.\n",DHT_MAX_SENSORS);
+		exit(1);
+	}
+
+	for ( ; optind < argc; ++optind ) {
+		type = dht11;
+		if ( (cp = strchr(argv[optind],':')) != 0 ) {
+			if ( !strcmp(cp+1,"22") || !strcmp(cp+1,"2302") )
+				type = dht22;
+			else if ( strcmp(cp+1,"11") )
+				goto usage;
+		}
+		s = &sched[nsensors];
+		if ( dht_open(&s->sensor,atoi(argv[optind]),type) )
+			exit(2);
+		min_ms = dht_min_interval_ms(type);
+		s->interval = (interval_ms > min_ms ? interval_ms : min_ms) * 1000000ULL;
+		++nsensors;
+	}
+
+	for ( x=0; x<MAX_CLIENTS; ++x )
+		clients[x].fd = -1;
+	if ( sock_path )
+		lfd = serve(sock_path);		/* Exits on failure: before the shm */
+
+	euid = user_begin();
+	if ( !(shm = dht_shm_create(shm_name,nsensors)) ) {
+		if ( lfd >= 0 )
+			unlink_socket(sock_path);
+		exit(2);
+	}
+	user_end(euid);
+
+	/*
+	 * Stagger the first reads over the longest interval
+	 */
+	for ( stagger=0, x=0; x<nsensors; ++x )
+		if ( sched[x].interval > stagger )
+			stagger = sched[x].interval;
+	stagger /= nsensors;
+
+	t0 = gpio_line_now();
+	for ( x=0; x<nsensors; ++x ) {
+		s = &sched[x];
+		shm->entry[x].gpio = s->sensor.gpio;
+		shm->entry[x].type = s->sensor.type;
+		shm->entry[x].status = dht_no_response;
+		dht_stats_init(&shm->entry[x].stats);
+		s->due = t0 + 1000000000ULL + x * stagger;
+		s->started = 0;
+	}
+
+	signal(SIGINT,sig_handler);
+	signal(SIGTERM,sig_handler);
+
+	while ( !is_signaled ) {
+		for ( s=&sched[0], x=1; x<nsensors; ++x )
+			if ( sched[x].due < s->due )
+				s = &sched[x];		/* Earliest due */
+		n = s - sched;
+
+		serve_until(lfd,s->due);
+		if ( is_signaled )
+			break;
+		if ( gpio_line_now() < s->due )
+			continue;		/* A request moved a read forward */
+
+		s->started = gpio_line_now();
+		status = dht_read(&s->sensor,&frame);
+
+		e = &shm->entry[n];
+		dht_shm_begin(e);
+		e->status = status;
+		if ( status == dht_ok ) {
+			dht_convert(&frame,s->sensor.type,&rh10,&temp10);
+			e->rh10 = rh10;
+			e->temp10 = temp10;
+			e->ns = s->started;
+		}
+		dht_stats_add(&e->stats,status,&frame);
+		dht_shm_end(e);
+
+		for ( x=0; x<MAX_CLIENTS; ++x )
+			if ( clients[x].fd >= 0 && clients[x].sensor == (int)n )
+				answer(&clients[x],n);	/* Were waiting for it */
+
+		if ( verbose ) {
+			if ( status == dht_ok )
+				printf("GPIO %d: RH %.1f%% Temp %.1f C\n",s->sensor.gpio,rh10/10.0,temp10/10.0);
+			else	printf("GPIO %d: %s\n",s->sensor.gpio,dht_status_name(status));
+			fflush(stdout);
+		}
+
+		/*
+		 * Keep the cadence, but never read again before the
+		 * minimum interval has passed since this start pulse.
+		 * Failed reads are retried on their own schedule.
+		 */
+		if ( status == dht_ok ) {
+			s->due += s->interval;
+			now = s->started + dht_min_interval_ms(s->sensor.type) * 1000000ULL;
+			if ( s->due < now )
+				s->due = now;
+		} else	{
+			interval = dht_retry_ms(&e->stats,s->sensor.type,s->interval / 1000000);
+			s->due = s->started + interval * 1000000ULL;
+		}
+	}
+
+	for ( x=0; x<nsensors; ++x )
+		dht_close(&sched[x].sensor);
+	dht_shm_close(shm);
+	user_begin();
+	shm_unlink(shm_name);
+	if ( lfd >= 0 ) {
+		close(lfd);
+		unlink_socket(sock_path);
+	}
+	return 0;
+}
+
+/*********************************************************************
+ * End dhtsched.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,148 @@
+/*********************************************************************
+ * ir_file.c : Recorded IR edge files for offline decoding
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ir_file.h"
+#include "edge_rec.h"
+#include "user_file.h"
+
+/*
+ * Internal : Append a period, growing the array as needed. Returns
+ * -1 when out of memory, with the array freed.
+ */
+static int
+add(ir_period_t **periods,unsigned *n,unsigned *max,int mark,unsigned us) {
+	ir_period_t *grown;
+
+	if ( *n >= *max ) {
+		*max = *max ? *max * 2 : 1024;
+		if ( !(grown = realloc(*periods,*max * sizeof **periods)) ) {
+			free(*periods);
+			*periods = 0;
+			*n = *max = 0;
+			return -1;
+		}
+		*periods = grown;
+	}
+	(*periods)[*n].mark = mark;
+	(*periods)[(*n)++].us = us;
+	return 0;
+}
+
+/*
+ * Internal : Periods between the edges of the first GPIO recorded.
+ * The receiver inverts, so the line is low during marks.
+ */
+static int
+load_edges(FILE *f,int noinvert,ir_period_t **periods,unsigned *n,unsigned *max) {
+	gpio_edge_t edge, last;
+	int have = 0;
+
+	while ( edge_rec_read(f,&edge) ) {
+		if ( have && edge.gpio != last.gpio )
+			continue;
+		if ( have && add(periods,n,max,!last.level ^ noinvert,(edge.ns - last.ns) / 1000) )
+			return -1;
+		last = edge;
+		have = 1;
+	}
+	return 0;
+}
+
+/*********************************************************************
+ * Load a text (irdecode -d), binary or edge recording into *periods,
+ * a malloc'd array of *n periods. Recordings made with irdecode -n
+ * need noinvert set. Returns 0, or -1 after reporting the error.
+ *********************************************************************/
+int
+ir_file_load(const char *path,int noinvert,ir_period_t **periods,unsigned *n) {
+	char buf[128];
+	unsigned max = 0, word;
+	size_t got;
+	double ms;
+	int level, rc = 0;
+	FILE *f;
+
+	*periods = 0;
+	*n = 0;
+
+	if ( !(f = user_fopen(path,"r")) ) {	/* Only what the user may read */
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),path);
+		return -1;
+	}
+
+	if ( (got = fread(buf,1,8,f)) < 8 ) {
+		fprintf(stderr,"%s: %s\n",path,ferror(f) ? strerror(errno) : "too short for a recording");
+		fclose(f);
+		return -1;
+	}
+
+	if ( !memcmp(buf,IR_FILE_MAGIC,8) ) {
+		while ( !rc && fread(&word,sizeof word,1,f) == 1 )
+			rc = add(periods,n,&max,(word & IR_FILE_MARK) != 0,word & IR_FILE_US);
+	} else if ( !memcmp(buf,EDGE_REC_MAGIC,8) ) {
+		rc = load_edges(f,noinvert,periods,n,&max);
+	} else	{
+		rewind(f);
+		while ( !rc && fgets(buf,sizeof buf,f) ) {
+			/* Other lines ("Monitoring GPIO..") are skipped */
+			if ( sscanf(buf,"%lf %d",&ms,&level) != 2 || ms < 0.0 )
+				continue;
+			/* The line gives the new level: the period had the other */
+			rc = add(periods,n,&max,!level ^ noinvert,(unsigned)(ms * 1000.0 + 0.5));
+		}
+	}
+
+	if ( rc ) {
+		fprintf(stderr,"Out of memory loading %s\n",path);
+		fclose(f);
+		return -1;
+	}
+
+	if ( ferror(f) ) {
+		fprintf(stderr,"%s: reading %s\n",strerror(errno),path);
+		fclose(f);
+		free(*periods);
+		*periods = 0;
+		return -1;
+	}
+	fclose(f);
+	return 0;
+}
+
+/*********************************************************************
+ * Create a binary recording (0 on failure, reported)
+ *********************************************************************/
+FILE *
+ir_file_create(const char *path) {
+	FILE *f = user_fopen(path,"w");		/* Not as root */
+
+	if ( !f )
+		fprintf(stderr,"%s: creating %s\n",strerror(errno),path);
+	else	fwrite(IR_FILE_MAGIC,1,8,f);
+	return f;
+}
+
+/*********************************************************************
+ * Write one period to a binary recording. Overlong periods (over 35
+ * minutes) are clipped.
+ *********************************************************************/
+int
+ir_file_put(FILE *f,int mark,unsigned long long us) {
+	unsigned word = us > IR_FILE_US ? IR_FILE_US : (unsigned)us;
+
+	if ( mark )
+		word |= IR_FILE_MARK;
+	return fwrite(&word,sizeof word,1,f) == 1 ? 0 : -1;
+}
+
+/*********************************************************************
+ * End ir_file.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,38 @@
+/*********************************************************************
+ * ir_file.h : Recorded IR edge files for offline decoding
+ *
+ * A recording is a list of periods: a mark (IR present) or a space
+ * and its length. Three formats are read:
+ *
+ *	text	the output of irdecode -d: one "ms level" line per
+ *		change, where ms is the length of the previous level
+ *	binary	IR_FILE_MAGIC, then one 32 bit word per period in host
+ *		byte order: microseconds, with IR_FILE_MARK set for marks
+ *	edges	an edge recording (edge_rec.h) of the receiver's line
+ *
+ * irsend -w writes the binary format, and irdecode -w the edges.
+ *********************************************************************/
+
+#ifndef IR_FILE_H
+#define IR_FILE_H
+
+#include <stdio.h>
+
+#include "ir_proto.h"
+
+#define IR_FILE_MAGIC	"IREDGE1\n"	/* 8 bytes */
+#define IR_FILE_MARK	0x80000000u	/* Period is a mark */
+#define IR_FILE_US	0x7FFFFFFFu	/* Microseconds */
+
+int ir_file_load(const char *path,int noinvert,ir_period_t **periods,unsigned *n);
+
+FILE *ir_file_create(const char *path);
+int ir_file_put(FILE *f,int mark,unsigned long long us);
+
+#endif /* IR_FILE_H */
+
+/*********************************************************************
+ * End ir_file.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
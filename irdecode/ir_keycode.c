@@ -0,0 +1,100 @@
+/*********************************************************************
+ * ir_keycode.c : Keymap key names to Linux input key codes
+ *********************************************************************/
+
+#include <string.h>
+#include <strings.h>
+#include <linux/input.h>
+
+#include "ir_keycode.h"
+
+static const struct {
+	const char	*name;		/* Keymap name */
+	unsigned	code;		/* KEY_* */
+} keycodes[] = {
+	{ "0",		KEY_0 },
+	{ "1",		KEY_1 },
+	{ "2",		KEY_2 },
+	{ "3",		KEY_3 },
+	{ "4",		KEY_4 },
+	{ "5",		KEY_5 },
+	{ "6",		KEY_6 },
+	{ "7",		KEY_7 },
+	{ "8",		KEY_8 },
+	{ "9",		KEY_9 },
+	{ "POWER",	KEY_POWER },
+	{ "MUTE",	KEY_MUTE },
+	{ "VOLUMEUP",	KEY_VOLUMEUP },
+	{ "VOLUME_UP",	KEY_VOLUMEUP },
+	{ "VOLUMEDOWN",	KEY_VOLUMEDOWN },
+	{ "VOLUME_DOWN",KEY_VOLUMEDOWN },
+	{ "CHANNELUP",	KEY_CHANNELUP },
+	{ "CHANNELDOWN",KEY_CHANNELDOWN },
+	{ "UP",		KEY_UP },
+	{ "DOWN",	KEY_DOWN },
+	{ "LEFT",	KEY_LEFT },
+	{ "RIGHT",	KEY_RIGHT },
+	{ "OK",		KEY_OK },
+	{ "ENTER",	KEY_ENTER },
+	{ "SELECT",	KEY_SELECT },
+	{ "EXIT",	KEY_EXIT },
+	{ "RETURN",	KEY_BACK },
+	{ "BACK",	KEY_BACK },
+	{ "MENU",	KEY_MENU },
+	{ "HOME",	KEY_HOMEPAGE },
+	{ "INFO",	KEY_INFO },
+	{ "EPG",	KEY_EPG },
+	{ "GUIDE",	KEY_EPG },
+	{ "TV",		KEY_TV },
+	{ "SOURCE",	KEY_VIDEO },
+	{ "PLAY",	KEY_PLAY },
+	{ "PAUSE",	KEY_PAUSE },
+	{ "PLAYPAUSE",	KEY_PLAYPAUSE },
+	{ "STOP",	KEY_STOP },
+	{ "RECORD",	KEY_RECORD },
+	{ "REWIND",	KEY_REWIND },
+	{ "FASTFORWARD",KEY_FASTFORWARD },
+	{ "NEXT",	KEY_NEXTSONG },
+	{ "PREVIOUS",	KEY_PREVIOUSSONG },
+	{ "RED",	KEY_RED },
+	{ "GREEN",	KEY_GREEN },
+	{ "YELLOW",	KEY_YELLOW },
+	{ "BLUE",	KEY_BLUE },
+	{ "SUBTITLE",	KEY_SUBTITLE },
+	{ "SLEEP",	KEY_SLEEP },
+};
+
+#define N_KEYCODES	(sizeof keycodes / sizeof keycodes[0])
+
+/*
+ * Return the KEY_* code for a key name, or -1 :
+ */
+int
+ir_keycode(const char *key) {
+	unsigned x;
+
+	if ( !strncasecmp(key,"KEY_",4) && key[4] )
+		key += 4;
+	for ( x=0; x<N_KEYCODES; ++x )
+		if ( !strcasecmp(keycodes[x].name,key) )
+			return keycodes[x].code;
+	return -1;
+}
+
+/*
+ * Store up to max of the known key codes, returning the count :
+ */
+unsigned
+ir_keycodes(unsigned *codes,unsigned max) {
+	unsigned x;
+
+	for ( x=0; x<N_KEYCODES && x<max; ++x )
+		codes[x] = keycodes[x].code;
+	return x;
+}
+
+/*********************************************************************
+ * End ir_keycode.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,21 @@
+/*********************************************************************
+ * ir_keycode.h : Keymap key names to Linux input key codes
+ *
+ * Key names are those of <linux/input.h> without the KEY_ prefix
+ * (VOLUMEUP, PLAYPAUSE, 5 ..), plus a few remote control names
+ * (RETURN, OK, NEXT ..). Names may also be given with the prefix.
+ *********************************************************************/
+
+#ifndef IR_KEYCODE_H
+#define IR_KEYCODE_H
+
+int ir_keycode(const char *key);	/* KEY_* code, or -1 */
+unsigned ir_keycodes(unsigned *codes,unsigned max);
+
+#endif /* IR_KEYCODE_H */
+
+/*********************************************************************
+ * End ir_keycode.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
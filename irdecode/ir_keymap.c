@@ -0,0 +1,250 @@
+/*********************************************************************
+ * ir_keymap.c : Hashed IR scancode to key name map
+ *
+ * Open addressing with linear probing, kept at most half full, so a
+ * lookup is one hash and (nearly always) one or two probes.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include "ir_keymap.h"
+#include "user_file.h"
+
+#define MIN_SLOTS	64		/* Initial table size (power of 2) */
+
+/*
+ * Samsung Remote Codes :
+ */
+#define IR_POWER	0xE0E040BF
+#define IR_0		0xE0E08877
+#define IR_1		0xE0E020DF
+#define IR_2		0xE0E0A05F
+#define IR_3		0xE0E0609F
+#define IR_4		0xE0E010EF
+#define IR_5		0xE0E0906F
+#define IR_6		0xE0E050AF
+#define IR_7		0xE0E030CF
+#define IR_8		0xE0E0B04F
+#define IR_9		0xE0E0708F
+#define IR_EXIT		0xE0E0B44B
+#define IR_RETURN	0xE0E01AE5
+#define IR_MUTE		0xE0E0F00F
+
+static const struct {
+	unsigned long	ir_code;	/* IR Code */
+	const char 	*key;		/* Key name */
+} ir_codes[] = {
+	{ IR_POWER,	"POWER" },
+	{ IR_0, 	"0" },
+	{ IR_1, 	"1" },
+	{ IR_2, 	"2" },
+	{ IR_3, 	"3" },
+	{ IR_4, 	"4" },
+	{ IR_5, 	"5" },
+	{ IR_6, 	"6" },
+	{ IR_7, 	"7" },
+	{ IR_8, 	"8" },
+	{ IR_9, 	"9" },
+	{ IR_EXIT,	"EXIT" },
+	{ IR_RETURN,	"RETURN" },
+	{ IR_MUTE,	"MUTE" },
+	{ 0, 		0 }		/* End marker */
+};
+
+typedef struct {
+	ir_proto_t	proto;		/* Protocol */
+	unsigned	scancode;	/* Scancode within it */
+	char		*key;		/* Key name, or 0 if slot is free */
+} ir_slot_t;
+
+struct ir_keymap {
+	ir_slot_t	*slots;		/* Hash table */
+	unsigned	size;		/* Slots (power of 2) */
+	unsigned	count;		/* Slots used */
+};
+
+/*
+ * Internal : Hash a protocol and scancode
+ */
+static inline unsigned
+hash(ir_proto_t proto,unsigned scancode) {
+	unsigned h = scancode ^ (unsigned)proto << 27;
+
+	h ^= h >> 16;
+	h *= 0x45D9F3Bu;
+	h ^= h >> 16;
+	return h;
+}
+
+/*
+ * Internal : Find the slot for proto/scancode: its own, or the free
+ * slot where it belongs.
+ */
+static ir_slot_t *
+probe(const ir_keymap_t *map,ir_proto_t proto,unsigned scancode) {
+	unsigned x = hash(proto,scancode) & (map->size - 1);
+	ir_slot_t *slot;
+
+	for (;;) {
+		slot = &map->slots[x];
+		if ( !slot->key || (slot->proto == proto && slot->scancode == scancode) )
+			return slot;
+		x = (x + 1) & (map->size - 1);
+	}
+}
+
+/*
+ * Internal : Double the table size
+ */
+static void
+grow(ir_keymap_t *map) {
+	ir_slot_t *old = map->slots;
+	unsigned x, size = map->size;
+
+	map->size *= 2;
+	map->slots = calloc(map->size,sizeof *map->slots);
+	for ( x=0; x<size; ++x )
+		if ( old[x].key )
+			*probe(map,old[x].proto,old[x].scancode) = old[x];
+	free(old);
+}
+
+/*********************************************************************
+ * Create an empty keymap
+ *********************************************************************/
+ir_keymap_t *
+ir_keymap_new(void) {
+	ir_keymap_t *map = malloc(sizeof *map);
+
+	map->size = MIN_SLOTS;
+	map->count = 0;
+	map->slots = calloc(map->size,sizeof *map->slots);
+	return map;
+}
+
+void
+ir_keymap_free(ir_keymap_t *map) {
+	unsigned x;
+
+	if ( !map )
+		return;
+	for ( x=0; x<map->size; ++x )
+		free(map->slots[x].key);
+	free(map->slots);
+	free(map);
+}
+
+/*********************************************************************
+ * Add or replace the key for proto/scancode
+ *********************************************************************/
+int
+ir_keymap_add(ir_keymap_t *map,ir_proto_t proto,unsigned scancode,const char *key) {
+	ir_slot_t *slot;
+
+	if ( (map->count + 1) * 2 > map->size )
+		grow(map);
+	slot = probe(map,proto,scancode);
+	if ( slot->key )
+		free(slot->key);
+	else	++map->count;
+	slot->proto = proto;
+	slot->scancode = scancode;
+	slot->key = strdup(key);
+	return 0;
+}
+
+/*********************************************************************
+ * Look up a key name, returning 0 if it is not mapped
+ *********************************************************************/
+const char *
+ir_keymap_find(const ir_keymap_t *map,ir_proto_t proto,unsigned scancode) {
+	return probe(map,proto,scancode)->key;
+}
+
+unsigned
+ir_keymap_count(const ir_keymap_t *map) {
+	return map->count;
+}
+
+/*********************************************************************
+ * Find the code for a key name (for transmitting). Returns 0, or -1
+ * if the key is not mapped. This is a linear search.
+ *********************************************************************/
+int
+ir_keymap_code(const ir_keymap_t *map,const char *key,ir_proto_t *proto,unsigned *scancode) {
+	unsigned x;
+
+	for ( x=0; x<map->size; ++x )
+		if ( map->slots[x].key && !strcmp(map->slots[x].key,key) ) {
+			*proto = map->slots[x].proto;
+			*scancode = map->slots[x].scancode;
+			return 0;
+		}
+	return -1;
+}
+
+/*********************************************************************
+ * The Samsung remote used in the book, when no keymap is given
+ *********************************************************************/
+ir_keymap_t *
+ir_keymap_default(void) {
+	ir_keymap_t *map = ir_keymap_new();
+	int kx;
+
+	for ( kx=0; ir_codes[kx].key; ++kx )
+		ir_keymap_add(map,ir_samsung,ir_codes[kx].ir_code,ir_codes[kx].key);
+	return map;
+}
+
+/*********************************************************************
+ * Load a keymap file. Errors are reported with the line number and
+ * 0 is returned.
+ *********************************************************************/
+ir_keymap_t *
+ir_keymap_load(const char *path) {
+	ir_keymap_t *map;
+	char buf[256], proto[32], code[32], key[64], *cp, *ep;
+	unsigned long scancode;
+	unsigned lno = 0;
+	int p, n;
+	FILE *f;
+
+	if ( !(f = user_fopen(path,"r")) ) {	/* Only what the user may read */
+		fprintf(stderr,"%s: opening keymap %s\n",strerror(errno),path);
+		return 0;
+	}
+
+	map = ir_keymap_new();
+	while ( fgets(buf,sizeof buf,f) ) {
+		++lno;
+		if ( (cp = strchr(buf,'#')) != 0 )
+			*cp = 0;
+		for ( cp=buf; isspace((unsigned char)*cp); ++cp )
+			;
+		if ( !*cp )
+			continue;		/* Blank or comment */
+
+		n = sscanf(cp,"%31s %31s %63s",proto,code,key);
+		if ( n == 3 )
+			scancode = strtoul(code,&ep,0);
+		if ( n != 3 || *ep || (p = ir_proto_lookup(proto)) < 0 ) {
+			fprintf(stderr,"%s line %u: expected protocol scancode key\n",path,lno);
+			ir_keymap_free(map);
+			fclose(f);
+			return 0;
+		}
+		ir_keymap_add(map,(ir_proto_t)p,scancode,key);
+	}
+	fclose(f);
+	return map;
+}
+
+/*********************************************************************
+ * End ir_keymap.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,37 @@
+/*********************************************************************
+ * ir_keymap.h : Hashed IR scancode to key name map
+ *
+ * A keymap file has one key per line:
+ *
+ *	# protocol	scancode	key
+ *	samsung		0xE0E0906F	5
+ *	rc5		0x0010		VOLUME_UP
+ *
+ * The protocol names and scancodes are those of ir_proto.h. Blank
+ * lines and text after '#' are ignored.
+ *********************************************************************/
+
+#ifndef IR_KEYMAP_H
+#define IR_KEYMAP_H
+
+#include "ir_proto.h"
+
+typedef struct ir_keymap ir_keymap_t;
+
+ir_keymap_t *ir_keymap_new(void);
+ir_keymap_t *ir_keymap_load(const char *path);
+ir_keymap_t *ir_keymap_default(void);
+void ir_keymap_free(ir_keymap_t *map);
+
+int ir_keymap_add(ir_keymap_t *map,ir_proto_t proto,unsigned scancode,const char *key);
+const char *ir_keymap_find(const ir_keymap_t *map,ir_proto_t proto,unsigned scancode);
+int ir_keymap_code(const ir_keymap_t *map,const char *key,ir_proto_t *proto,unsigned *scancode);
+unsigned ir_keymap_count(const ir_keymap_t *map);
+
+#endif /* IR_KEYMAP_H */
+
+/*********************************************************************
+ * End ir_keymap.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,581 @@
+/*********************************************************************
+ * ir_proto.c : Table-driven IR remote control protocol decoders
+ *
+ * A protocol is described by its timing in timings[] and decoded by
+ * one of four codings. Adding a protocol with a known coding is a
+ * new table row plus functions converting between its bits and a
+ * scancode.
+ *********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ir_proto.h"
+
+#define TOLERANCE	35		/* Percent error accepted in a period */
+#define QUIET_US	5000		/* Space before an RC5 frame */
+
+typedef enum {
+	pulse_distance,			/* Fixed mark, space length is the bit */
+	pulse_width,			/* Mark length is the bit, fixed space */
+	manchester_rc5,			/* Space then mark is a 1 */
+	manchester_rc6			/* Mark then space is a 1 */
+} ir_coding_t;
+
+typedef enum {
+	st_idle = 0,			/* Waiting for a leader */
+	st_lead_space,			/* Leader mark seen */
+	st_mark,			/* Expecting a bit mark */
+	st_space,			/* Expecting a bit space */
+	st_repeat,			/* Repeat leader: expecting the stop mark */
+	st_halves			/* Manchester half bits */
+} ir_state_t;
+
+typedef struct {
+	ir_coding_t	coding;		/* How bits are sent */
+	unsigned	lead_mark;	/* Leader mark (us), 0 for none */
+	unsigned	lead_space;	/* Leader space */
+	unsigned	repeat_space;	/* Repeat frame leader space, or 0 */
+	unsigned	unit;		/* Bit mark, space or Manchester half bit */
+	unsigned	zero;		/* Space (distance) or mark (width) of 0 */
+	unsigned	one;		/* Space (distance) or mark (width) of 1 */
+	unsigned	min_bits;	/* Shortest frame */
+	unsigned	max_bits;	/* Longest frame */
+	unsigned	wide_bit;	/* Manchester bit of double width, or ~0 */
+	int		lsb_first;	/* Bits arrive least significant first */
+	unsigned	frame_us;	/* Start to start of repeated frames */
+	int		(*code)(unsigned long long bits,unsigned n,ir_code_t *code);
+	int		(*bits)(const ir_code_t *code,unsigned long long *bits,unsigned *n);
+} ir_timing_t;
+
+typedef struct {
+	ir_state_t	state;		/* Where we are in a frame */
+	unsigned	n;		/* Bits received */
+	unsigned long long bits;	/* Bits received */
+	int		first;		/* Manchester: first half level, or -1 */
+	int		half;		/* Manchester: level being collected */
+	unsigned	units;		/* Manchester: units of it so far */
+	ir_code_t	last;		/* Last code, for repeat frames */
+	int		have_last;	/* True when last is valid */
+} ir_machine_t;
+
+static const char *proto_names[] = { "nec", "necx", "samsung", "rc5", "rc6", "sony" };
+
+/*
+ * NEC: address, ~address, command, ~command. Extended NEC uses the
+ * second byte for 8 more address bits.
+ */
+static int
+nec_code(unsigned long long bits,unsigned n,ir_code_t *code) {
+	unsigned a = bits & 0xFF, na = bits >> 8 & 0xFF;
+	unsigned c = bits >> 16 & 0xFF, nc = bits >> 24 & 0xFF;
+
+	if ( (c ^ nc) != 0xFF )
+		return -1;
+	if ( (a ^ na) == 0xFF ) {
+		code->proto = ir_nec;
+		code->scancode = a << 8 | c;
+	} else	{
+		code->proto = ir_necx;
+		code->scancode = (na << 8 | a) << 8 | c;
+	}
+	return 0;
+}
+
+static int
+nec_bits(const ir_code_t *code,unsigned long long *bits,unsigned *n) {
+	unsigned a = code->scancode >> 8, c = code->scancode & 0xFF;
+
+	if ( code->proto == ir_nec )
+		a = (a & 0xFF) | (~a & 0xFF) << 8;
+	*bits = (a & 0xFFFF) | c << 16 | (~c & 0xFFULL) << 24;
+	*n = 32;
+	return 0;
+}
+
+/*
+ * Samsung32: kept whole, as printed by earlier versions of irdecode
+ */
+static int
+samsung_code(unsigned long long bits,unsigned n,ir_code_t *code) {
+	if ( ((bits >> 8 ^ bits) & 0xFF) != 0xFF )
+		return -1;		/* Command check byte */
+	code->proto = ir_samsung;
+	code->scancode = bits;
+	return 0;
+}
+
+static int
+samsung_bits(const ir_code_t *code,unsigned long long *bits,unsigned *n) {
+	*bits = code->scancode;
+	*n = 32;
+	return 0;
+}
+
+/*
+ * RC5: S1, S2 (inverted command bit 6 in RC5X), toggle, 5 address
+ * and 6 command bits.
+ */
+static int
+rc5_code(unsigned long long bits,unsigned n,ir_code_t *code) {
+	if ( !(bits >> 13 & 1) )
+		return -1;		/* S1 */
+	code->proto = ir_rc5;
+	code->toggle = bits >> 11 & 1;
+	code->scancode = (bits >> 6 & 0x1F) << 8 | (bits & 0x3F) | (~bits >> 12 & 1) << 6;
+	return 0;
+}
+
+static int
+rc5_bits(const ir_code_t *code,unsigned long long *bits,unsigned *n) {
+	unsigned a = code->scancode >> 8, c = code->scancode & 0xFF;
+
+	if ( a > 0x1F || c > 0x7F )
+		return -1;
+	*bits = 1 << 13 | (~c >> 6 & 1) << 12 | (code->toggle & 1) << 11 | a << 6 | (c & 0x3F);
+	*n = 14;
+	return 0;
+}
+
+/*
+ * RC6: start bit, 3 mode bits, toggle, 8 address and 8 command bits
+ */
+static int
+rc6_code(unsigned long long bits,unsigned n,ir_code_t *code) {
+	if ( !(bits >> 20 & 1) || (bits >> 17 & 7) != 0 )
+		return -1;		/* Start bit, or not mode 0 */
+	code->proto = ir_rc6;
+	code->toggle = bits >> 16 & 1;
+	code->scancode = bits & 0xFFFF;
+	return 0;
+}
+
+static int
+rc6_bits(const ir_code_t *code,unsigned long long *bits,unsigned *n) {
+	if ( code->scancode > 0xFFFF )
+		return -1;
+	*bits = 1 << 20 | (code->toggle & 1) << 16 | code->scancode;
+	*n = 21;
+	return 0;
+}
+
+/*
+ * Sony: 7 command bits, then 5 device bits (12 bit frames), 8 device
+ * bits (15 bit) or 5 device and 8 extension bits (20 bit).
+ */
+static int
+sony_code(unsigned long long bits,unsigned n,ir_code_t *code) {
+	unsigned dev, ext = 0;
+
+	switch ( n ) {
+	case 12 :
+		dev = bits >> 7 & 0x1F;
+		break;
+	case 15 :
+		dev = bits >> 7 & 0xFF;
+		break;
+	case 20 :
+		dev = bits >> 7 & 0x1F;
+		ext = bits >> 12 & 0xFF;
+		break;
+	default :
+		return -1;
+	}
+	code->proto = ir_sony;
+	code->scancode = dev << 16 | ext << 8 | (bits & 0x7F);
+	return 0;
+}
+
+static int
+sony_bits(const ir_code_t *code,unsigned long long *bits,unsigned *n) {
+	unsigned dev = code->scancode >> 16, ext = code->scancode >> 8 & 0xFF;
+	unsigned cmd = code->scancode & 0xFF;
+
+	if ( cmd > 0x7F || dev > 0xFF || (ext && dev > 0x1F) )
+		return -1;
+	*n = ext ? 20 : dev > 0x1F ? 15 : 12;
+	*bits = cmd | dev << 7 | (unsigned long long)ext << 12;
+	return 0;
+}
+
+static const ir_timing_t timings[] = {
+	/* NEC and extended NEC: 9ms leader, 2.25ms space for a repeat */
+	{ pulse_distance, 9000, 4500, 2250, 560, 560, 1690, 32, 32, ~0u, 1, 108000,
+	  nec_code, nec_bits },
+	/* Samsung32: 4.5ms leader */
+	{ pulse_distance, 4500, 4500, 0, 560, 560, 1690, 32, 32, ~0u, 0, 108000,
+	  samsung_code, samsung_bits },
+	/* RC5: no leader, 889us half bits */
+	{ manchester_rc5, 0, 0, 0, 889, 0, 0, 14, 14, ~0u, 0, 113778,
+	  rc5_code, rc5_bits },
+	/* RC6 mode 0: 2.666ms leader, 444us half bits, double width toggle */
+	{ manchester_rc6, 2666, 889, 0, 444, 0, 0, 21, 21, 4, 0, 106667,
+	  rc6_code, rc6_bits },
+	/* Sony SIRC: 2.4ms leader, 0.6ms spaces */
+	{ pulse_width, 2400, 600, 0, 600, 600, 1200, 12, 20, ~0u, 1, 45000,
+	  sony_code, sony_bits },
+};
+
+/* Row of timings[] for each ir_proto_t */
+static const unsigned proto_rows[] = { 0, 0, 1, 2, 3, 4 };
+
+#define N_TIMINGS	(sizeof timings / sizeof timings[0])
+
+struct ir_decoder {
+	ir_machine_t	m[N_TIMINGS];	/* One state machine per row */
+	int		quiet;		/* Last period was a long space */
+};
+
+/*
+ * Internal : True when us is within TOLERANCE percent of want
+ */
+static inline int
+near(unsigned us,unsigned want) {
+	unsigned long long u = us * 100ULL;
+
+	return u >= want * (100ULL - TOLERANCE) && u <= want * (100ULL + TOLERANCE);
+}
+
+/*
+ * Internal : The number of whole units (1 to max) in us, or 0
+ */
+static unsigned
+units(unsigned us,unsigned unit,unsigned max) {
+	unsigned n, diff;
+
+	if ( us > unit * (max + 1) )
+		return 0;
+	n = (us + unit / 2) / unit;
+	if ( n < 1 || n > max )
+		return 0;
+	diff = us > n * unit ? us - n * unit : n * unit - us;
+	return diff * 100 <= unit * TOLERANCE ? n : 0;
+}
+
+/*
+ * Internal : Begin collecting bits
+ */
+static void
+begin(ir_machine_t *m) {
+	m->n = 0;
+	m->bits = 0;
+	m->first = -1;
+	m->units = 0;
+}
+
+/*
+ * Internal : Add a bit to the frame
+ */
+static void
+push_bit(ir_machine_t *m,const ir_timing_t *t,int b) {
+	if ( !t->lsb_first )
+		m->bits = m->bits << 1 | b;
+	else if ( m->n < 64 )
+		m->bits |= (unsigned long long)b << m->n;
+	++m->n;
+}
+
+/*
+ * Internal : Frame complete: convert to a code. Returns 1 if valid.
+ */
+static int
+emit(ir_machine_t *m,const ir_timing_t *t,ir_code_t *code) {
+	memset(code,0,sizeof *code);
+	code->bits = m->n;
+	m->state = st_idle;
+	if ( t->code(m->bits,m->n,code) )
+		return 0;
+	m->last = *code;
+	m->have_last = 1;
+	return 1;
+}
+
+/*
+ * Internal : Add one unit of level to a Manchester frame. Returns 1
+ * when the frame is complete, -1 on a coding error, else 0.
+ */
+static int
+manch_unit(ir_machine_t *m,const ir_timing_t *t,int level) {
+	unsigned need = m->n == t->wide_bit ? 2 : 1;
+
+	if ( m->units && level != m->half )
+		return -1;		/* Half bit cut short */
+	m->half = level;
+	if ( ++m->units < need )
+		return 0;
+	m->units = 0;
+
+	if ( m->first < 0 ) {
+		m->first = level;	/* First half of a bit */
+		return 0;
+	}
+	if ( level == m->first )
+		return -1;		/* No transition mid bit */
+	push_bit(m,t,t->coding == manchester_rc5 ? level : m->first);
+	m->first = -1;
+	return m->n >= t->max_bits;
+}
+
+/*
+ * Internal : Add a period to a Manchester frame. A long space ends
+ * the frame, completing a last bit that ends with a space.
+ */
+static int
+manch_period(ir_machine_t *m,const ir_timing_t *t,int mark,unsigned us) {
+	unsigned n = units(us,t->unit,3), x;
+	int rc;
+
+	if ( !n ) {
+		if ( mark || us < t->unit * 3 )
+			return -1;
+		for ( x=0; x<4 && (m->first >= 0 || m->units); ++x )
+			if ( (rc = manch_unit(m,t,0)) != 0 )
+				return rc;
+		return -1;
+	}
+	for ( x=0; x<n; ++x )
+		if ( (rc = manch_unit(m,t,mark)) != 0 )
+			return rc;
+	return 0;
+}
+
+/*
+ * Internal : Run one state machine over one period. Returns 1 when
+ * *code holds a decoded frame.
+ */
+static int
+feed(ir_machine_t *m,const ir_timing_t *t,int mark,unsigned us,int quiet,ir_code_t *code) {
+	int rc;
+
+	switch ( m->state ) {
+	case st_idle :
+		break;
+	case st_lead_space :
+		if ( mark )
+			break;
+		if ( near(us,t->lead_space) ) {
+			begin(m);
+			m->state = t->coding == pulse_distance || t->coding == pulse_width
+				? st_mark : st_halves;
+			return 0;
+		}
+		if ( t->repeat_space && near(us,t->repeat_space) ) {
+			m->state = st_repeat;
+			return 0;
+		}
+		break;
+	case st_mark :
+		if ( !mark )
+			break;
+		if ( t->coding == pulse_distance ) {
+			if ( !near(us,t->unit) )
+				break;
+			if ( m->n >= t->max_bits )
+				return emit(m,t,code);	/* Stop mark */
+		} else if ( near(us,t->zero) ) {
+			push_bit(m,t,0);
+		} else if ( near(us,t->one) ) {
+			push_bit(m,t,1);
+		} else	break;
+		m->state = st_space;
+		return 0;
+	case st_space :
+		if ( mark )
+			break;
+		if ( t->coding == pulse_width ) {
+			if ( m->n < t->max_bits && near(us,t->unit) ) {
+				m->state = st_mark;
+				return 0;
+			}
+			if ( us > t->lead_mark && m->n >= t->min_bits )
+				return emit(m,t,code);	/* Ends at a gap */
+			break;
+		}
+		if ( near(us,t->zero) )
+			push_bit(m,t,0);
+		else if ( near(us,t->one) )
+			push_bit(m,t,1);
+		else	break;
+		m->state = st_mark;
+		return 0;
+	case st_repeat :
+		m->state = st_idle;
+		if ( mark && near(us,t->unit) && m->have_last ) {
+			*code = m->last;
+			code->repeat = 1;
+			return 1;
+		}
+		break;
+	case st_halves :
+		if ( (rc = manch_period(m,t,mark,us)) > 0 )
+			return emit(m,t,code);
+		if ( !rc )
+			return 0;
+		break;
+	}
+
+	/*
+	 * Not part of a frame: perhaps the start of the next one
+	 */
+	m->state = st_idle;
+	if ( !mark )
+		return 0;
+	if ( t->lead_mark ) {
+		if ( near(us,t->lead_mark) )
+			m->state = st_lead_space;
+	} else if ( quiet ) {
+		begin(m);			/* RC5: idle is the first half */
+		m->state = st_halves;
+		if ( manch_unit(m,t,0) || manch_period(m,t,mark,us) )
+			m->state = st_idle;
+	}
+	return 0;
+}
+
+/*********************************************************************
+ * Create a decoder running every protocol
+ *********************************************************************/
+ir_decoder_t *
+ir_decoder_new(void) {
+	ir_decoder_t *dec = malloc(sizeof *dec);
+
+	ir_reset(dec);
+	return dec;
+}
+
+void
+ir_decoder_free(ir_decoder_t *dec) {
+	free(dec);
+}
+
+/*********************************************************************
+ * Forget any partial frames and the last codes seen
+ *********************************************************************/
+void
+ir_reset(ir_decoder_t *dec) {
+	memset(dec,0,sizeof *dec);
+	dec->quiet = 1;
+}
+
+/*********************************************************************
+ * Feed one period: a mark (IR present) or a space, us long. Returns
+ * 1 when a frame completes, with its code in *code.
+ *********************************************************************/
+int
+ir_feed(ir_decoder_t *dec,int mark,unsigned us,ir_code_t *code) {
+	ir_code_t c;
+	unsigned x;
+	int got = 0;
+
+	for ( x=0; x<N_TIMINGS; ++x )
+		if ( feed(&dec->m[x],&timings[x],mark,us,dec->quiet,&c) && !got ) {
+			*code = c;
+			got = 1;
+		}
+	dec->quiet = !mark && us >= QUIET_US;
+	return got;
+}
+
+/*
+ * Internal : Append a period to an encoding, merging it with the
+ * last one when the level is the same. Leading spaces are dropped.
+ */
+static void
+put(ir_period_t *periods,unsigned *n,unsigned max,int mark,unsigned us) {
+	if ( *n && periods[*n-1].mark == mark ) {
+		periods[*n-1].us += us;
+	} else if ( *n || mark ) {
+		if ( *n < max ) {
+			periods[*n].mark = mark;
+			periods[*n].us = us;
+		}
+		++*n;
+	}
+}
+
+/*********************************************************************
+ * Encode code as the marks and spaces to transmit, starting with a
+ * mark and ending with the last mark. NEC codes with repeat set give
+ * the repeat frame. Returns the number of periods stored, or -1 if
+ * the code cannot be sent or needs more than max periods.
+ *********************************************************************/
+int
+ir_encode(const ir_code_t *code,ir_period_t *periods,unsigned max) {
+	const ir_timing_t *t;
+	unsigned long long bits;
+	unsigned nbits, x, half, n = 0;
+	int b;
+
+	if ( (unsigned)code->proto >= ir_n_protos )
+		return -1;
+	t = &timings[proto_rows[code->proto]];
+
+	if ( t->lead_mark )
+		put(periods,&n,max,1,t->lead_mark);
+	if ( code->repeat && t->repeat_space ) {
+		put(periods,&n,max,0,t->repeat_space);
+		put(periods,&n,max,1,t->unit);
+		return n <= max ? (int)n : -1;
+	}
+	if ( t->bits(code,&bits,&nbits) )
+		return -1;
+	if ( t->lead_mark && t->coding != pulse_width )
+		put(periods,&n,max,0,t->lead_space);
+
+	for ( x=0; x<nbits; ++x ) {
+		b = t->lsb_first ? bits >> x & 1 : bits >> (nbits - 1 - x) & 1;
+		switch ( t->coding ) {
+		case pulse_distance :
+			put(periods,&n,max,1,t->unit);
+			put(periods,&n,max,0,b ? t->one : t->zero);
+			break;
+		case pulse_width :
+			put(periods,&n,max,0,t->unit);
+			put(periods,&n,max,1,b ? t->one : t->zero);
+			break;
+		case manchester_rc5 :
+		case manchester_rc6 :
+			half = x == t->wide_bit ? t->unit * 2 : t->unit;
+			if ( t->coding == manchester_rc5 )
+				b = !b;		/* A 1 is space, then mark */
+			put(periods,&n,max,b,half);
+			put(periods,&n,max,!b,half);
+			break;
+		}
+	}
+	if ( t->coding == pulse_distance )
+		put(periods,&n,max,1,t->unit);		/* Stop mark */
+	if ( n && !periods[n-1].mark )
+		--n;				/* Trailing space */
+	return n <= max ? (int)n : -1;
+}
+
+/*********************************************************************
+ * Return the time from the start of one frame to the next, when a
+ * key is held.
+ *********************************************************************/
+unsigned
+ir_frame_us(ir_proto_t proto) {
+	return (unsigned)proto < ir_n_protos ? timings[proto_rows[proto]].frame_us : 0;
+}
+
+const char *
+ir_proto_name(ir_proto_t proto) {
+	return (unsigned)proto < ir_n_protos ? proto_names[proto] : "?";
+}
+
+int
+ir_proto_lookup(const char *name) {
+	int x;
+
+	for ( x=0; x<ir_n_protos; ++x )
+		if ( !strcmp(name,proto_names[x]) )
+			return x;
+	return -1;
+}
+
+/*********************************************************************
+ * End ir_proto.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,70 @@
+/*********************************************************************
+ * ir_proto.h : Table-driven IR remote control protocol decoders
+ *
+ * All decoders watch the same stream of marks (IR received) and
+ * spaces, fed one period at a time to ir_feed(). Each runs its own
+ * state machine, so remotes of different protocols can be mixed.
+ * Feed a space of IR_END_US after the last edge of a frame, so the
+ * protocols that end with a mark (Sony, RC5, RC6) can finish.
+ *
+ * ir_encode() goes the other way, from the same timing table, giving
+ * the periods to transmit for a code.
+ *
+ * Scancodes are those used in keymaps:
+ *
+ *	nec	address << 8 | command
+ *	necx	16 bit address << 8 | command
+ *	samsung	the 32 bits as sent, first bit most significant
+ *	rc5	address << 8 | command (7 bits for RC5X)
+ *	rc6	address << 8 | command (mode 0)
+ *	sony	device << 16 | extension << 8 | command
+ *********************************************************************/
+
+#ifndef IR_PROTO_H
+#define IR_PROTO_H
+
+#define IR_END_US	100000		/* Space that ends any frame */
+
+typedef enum {
+	ir_nec = 0,			/* NEC, 8 bit address */
+	ir_necx,			/* Extended NEC, 16 bit address */
+	ir_samsung,			/* Samsung32 */
+	ir_rc5,				/* Philips RC5 / RC5X */
+	ir_rc6,				/* Philips RC6 mode 0 */
+	ir_sony,			/* Sony SIRC 12, 15 or 20 bit */
+	ir_n_protos
+} ir_proto_t;
+
+typedef struct {
+	ir_proto_t	proto;		/* Protocol decoded */
+	unsigned	scancode;	/* See above */
+	unsigned	bits;		/* Bits received */
+	int		toggle;		/* RC5/RC6 toggle bit, else 0 */
+	int		repeat;		/* NEC repeat frame (scancode of last) */
+} ir_code_t;
+
+typedef struct {
+	unsigned	us;		/* Length in microseconds */
+	int		mark;		/* True if IR was present */
+} ir_period_t;
+
+typedef struct ir_decoder ir_decoder_t;
+
+ir_decoder_t *ir_decoder_new(void);
+void ir_decoder_free(ir_decoder_t *dec);
+void ir_reset(ir_decoder_t *dec);
+int ir_feed(ir_decoder_t *dec,int mark,unsigned us,ir_code_t *code);
+
+int ir_encode(const ir_code_t *code,ir_period_t *periods,unsigned max);
+unsigned ir_frame_us(ir_proto_t proto);
+
+const char *ir_proto_name(ir_proto_t proto);
+int ir_proto_lookup(const char *name);	/* ir_proto_t, or -1 */
+
+#endif /* IR_PROTO_H */
+
+/*********************************************************************
+ * End ir_proto.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,119 @@
+/*********************************************************************
+ * ir_repeat.c : Key press, repeat and release events from IR codes
+ *
+ * A key is held while the same code (NEC: a repeat frame; RC5/RC6:
+ * the same toggle bit) arrives within IR_HOLD_FRAMES frame periods
+ * of the last. Releasing and pressing a key again takes longer, and
+ * changes the RC5/RC6 toggle, so a new press is reported with the
+ * frame that carries it.
+ *********************************************************************/
+
+#include <string.h>
+
+#include "ir_repeat.h"
+
+#define IR_HOLD_FRAMES	2.5		/* Frame periods a held key repeats within */
+
+/*
+ * Internal : Time the held key is released unless another frame comes
+ */
+static inline unsigned long long
+release_ns(const ir_repeat_t *rep) {
+	return rep->t_last + (unsigned long long)(ir_frame_us(rep->code.proto) * 1000.0 * IR_HOLD_FRAMES);
+}
+
+/*
+ * Internal : Store an event for the held key
+ */
+static unsigned
+event(const ir_repeat_t *rep,int value,unsigned long long ns,ir_event_t *ev) {
+	ev->code = rep->code;
+	ev->code.repeat = 0;
+	ev->value = value;
+	ev->ns = ns;
+	return 1;
+}
+
+/*********************************************************************
+ * Set up for autorepeat after delay_ms, then every rate_ms. A delay
+ * of 0 gives only presses and releases.
+ *********************************************************************/
+void
+ir_repeat_init(ir_repeat_t *rep,unsigned delay_ms,unsigned rate_ms) {
+	memset(rep,0,sizeof *rep);
+	rep->delay_ns = delay_ms * 1000000ULL;
+	rep->rate_ns = (rate_ms ? rate_ms : 1) * 1000000ULL;
+}
+
+/*********************************************************************
+ * Take a code decoded at time ns, storing up to IR_MAX_EVENTS in
+ * evs[]: the release of a different key held, and the press of this
+ * one. Returns the number of events.
+ *********************************************************************/
+unsigned
+ir_repeat_code(ir_repeat_t *rep,const ir_code_t *code,unsigned long long ns,ir_event_t *evs) {
+	unsigned n = 0;
+
+	if ( rep->held ) {
+		if ( code->proto == rep->code.proto && code->scancode == rep->code.scancode
+		  && code->toggle == rep->code.toggle && ns < release_ns(rep) ) {
+			rep->t_last = ns;
+			return 0;			/* Still held */
+		}
+		n += event(rep,IR_RELEASE,ns,&evs[n]);
+		rep->held = 0;
+	}
+	if ( code->repeat )
+		return n;			/* Repeats a missed frame */
+
+	rep->held = 1;
+	rep->code = *code;
+	rep->t_last = ns;
+	rep->t_repeat = rep->delay_ns ? ns + rep->delay_ns : 0;
+	n += event(rep,IR_PRESS,ns,&evs[n]);
+	return n;
+}
+
+/*********************************************************************
+ * Report the next event due by time ns: a repeat, or the release of
+ * a key no longer sent. Call until it returns 0, as one call returns
+ * at most one event.
+ *********************************************************************/
+unsigned
+ir_repeat_poll(ir_repeat_t *rep,unsigned long long ns,ir_event_t *evs) {
+	unsigned long long t_release;
+
+	if ( !rep->held )
+		return 0;
+
+	t_release = release_ns(rep);
+	if ( rep->t_repeat && rep->t_repeat < t_release && rep->t_repeat <= ns ) {
+		event(rep,IR_REPEAT,rep->t_repeat,evs);
+		rep->t_repeat += rep->rate_ns;
+		return 1;
+	}
+	if ( t_release <= ns ) {
+		rep->held = 0;
+		return event(rep,IR_RELEASE,t_release,evs);
+	}
+	return 0;
+}
+
+/*********************************************************************
+ * Time by which ir_repeat_poll() has an event, or 0 if no key is held
+ *********************************************************************/
+unsigned long long
+ir_repeat_deadline(const ir_repeat_t *rep) {
+	unsigned long long t_release;
+
+	if ( !rep->held )
+		return 0;
+	t_release = release_ns(rep);
+	return rep->t_repeat && rep->t_repeat < t_release ? rep->t_repeat : t_release;
+}
+
+/*********************************************************************
+ * End ir_repeat.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
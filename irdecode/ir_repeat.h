@@ -0,0 +1,52 @@
+/*********************************************************************
+ * ir_repeat.h : Key press, repeat and release events from IR codes
+ *
+ * Remotes resend a frame (or a NEC repeat frame) every frame period
+ * while a key is held. ir_repeat_code() turns decoded codes into a
+ * press when a key goes down, and ir_repeat_poll() reports, as time
+ * passes, autorepeats (after delay_ms, then every rate_ms) and the
+ * release once the frames stop. Neither blocks: the caller waits
+ * for edges no later than ir_repeat_deadline().
+ *
+ * Event values are those of EV_KEY events (<linux/input.h>), and
+ * event times are when each was due, so that now - ns is latency.
+ *********************************************************************/
+
+#ifndef IR_REPEAT_H
+#define IR_REPEAT_H
+
+#include "ir_proto.h"
+
+#define IR_RELEASE	0		/* Key up */
+#define IR_PRESS	1		/* Key down */
+#define IR_REPEAT	2		/* Autorepeat */
+
+#define IR_MAX_EVENTS	2		/* Most events returned by one call */
+
+typedef struct {
+	ir_code_t	code;		/* Code of the key */
+	int		value;		/* IR_PRESS, IR_REPEAT or IR_RELEASE */
+	unsigned long long ns;		/* CLOCK_MONOTONIC time it was due */
+} ir_event_t;
+
+typedef struct {
+	unsigned long long delay_ns;	/* Press to first repeat, 0 for none */
+	unsigned long long rate_ns;	/* Between repeats */
+	int		held;		/* True while a key is down */
+	ir_code_t	code;		/* The key down */
+	unsigned long long t_last;	/* Last frame of the key down */
+	unsigned long long t_repeat;	/* Next repeat due, 0 for none */
+} ir_repeat_t;
+
+void ir_repeat_init(ir_repeat_t *rep,unsigned delay_ms,unsigned rate_ms);
+unsigned ir_repeat_code(ir_repeat_t *rep,const ir_code_t *code,unsigned long long ns,ir_event_t *evs);
+unsigned ir_repeat_poll(ir_repeat_t *rep,unsigned long long ns,ir_event_t *evs);
+unsigned long long ir_repeat_deadline(const ir_repeat_t *rep);
+
+#endif /* IR_REPEAT_H */
+
+/*********************************************************************
+ * End ir_repeat.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
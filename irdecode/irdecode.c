@@ -1,5 +1,24 @@
 /*********************************************************************
  * irdecode.c : Read IR remote control on GPIO 17 (GEN0)
+ *
+ * Edges arrive from the kernel in batches with the time they happened
+ * (gpio_line.h), so pulse widths do not include our wakeup latency.
+ * Each period goes through every protocol decoder (ir_proto.h) as
+ * its ending edge arrives, and the codes become key press, repeat
+ * and release events (ir_repeat.h). Codes are named by a keymap
+ * (ir_keymap.h): the built-in Samsung remote, or a -k file.
+ *
+ * -w records the edges (edge_rec.h: convert with edgeexport for a
+ * waveform), and -f decodes a recording (that, irsend -w, or the text
+ * of -d) instead of the GPIO, at full speed.
+ * -b n replays it n times and reports the decoding rate. -L replays
+ * it in real time on the simulated line, and reports the latency from
+ * each frame's last edge to its key event.
+ *
+ * As a daemon (-D), key presses are posted as Linux key events on a
+ * uinput device (-u, see ir_keycode.h for the key names) and/or
+ * published as "key:NAME" on a ZMQ PUB socket (-z endpoint, when
+ * built with libzmq), instead of being displayed.
  *********************************************************************/
 
 #include <stdio.h>
@@ -11,308 +30,505 @@
 #include <signal.h>
 #include <setjmp.h>
 #include <assert.h>
-#include <sys/time.h>
-#include <sys/poll.h>
 #include <getopt.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef IR_ZMQ
+#include <zmq.h>
+#endif
+
+#include "gpio_line.h"			/* Kernel GPIO lines (libgpio) */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
+#include "uinput_dev.h"			/* uinput routines (libgpio) */
+#include "edge_rec.h"			/* Edge recording (libgpio) */
+#include "ir_proto.h"			/* IR protocol decoders */
+#include "ir_keymap.h"			/* Scancode to key names */
+#include "ir_file.h"			/* Recorded edges */
+#include "ir_keycode.h"			/* Key names to KEY_* codes */
+#include "ir_repeat.h"			/* Press, repeat and release */
 
 static int gpio_inpin = 17;	/* GPIO input pin */
 static int is_signaled = 0;	/* Exit program if signaled */
-static int gpio_fd = -1;	/* Open file descriptor */
+static gpio_line_t *ir_line = 0; /* GPIO input line */
+static unsigned long long last_ns = 0; /* Time of the last change */
+
+#define IR_BATCH	128		/* Edges read per system call */
+#define IR_GAP_MS	10		/* Quiet time ending a frame */
+#define IR_MAX_LAT	4096		/* Latencies kept per event type (-L) */
+
+static gpio_edge_t ir_queue[IR_BATCH];	/* Edges read but not taken */
+static unsigned ir_head = 0;		/* Next edge in ir_queue[] */
+static unsigned ir_count = 0;		/* Edges left in ir_queue[] */
+static unsigned long long edge_ns = 0;	/* Time of the last edge taken */
+static int edge_level = 1;		/* Level after it */
+static int in_frame = 0;		/* True until a quiet gap */
 
 static jmp_buf jmp_exit;
 
-typedef enum {
-	gp_export=0,	/* /sys/class/gpio/export */
-	gp_unexport,	/* /sys/class/gpio/unexport */
-	gp_direction,	/* /sys/class/gpio%d/direction */
-	gp_edge,	/* /sys/class/gpio%d/edge */
-	gp_value	/* /sys/class/gpio%d/value */
-} gpio_path_t;
+static ir_decoder_t *ir_dec = 0;	/* All protocol decoders */
+static ir_keymap_t *ir_map = 0;		/* Scancode to key name */
+static ir_repeat_t ir_rep;		/* Key held, and autorepeat */
+static unsigned rep_delay = 500, rep_rate = 125; /* Autorepeat ms (-a) */
+static edge_rec_t *ir_rec = 0;		/* Recording edges (-w), or 0 */
+static int uinput_fd = -1;		/* Key events (-u), or -1 */
+#ifdef IR_ZMQ
+static void *zmq_context = 0;
+static void *publisher = 0;		/* Publishing socket (-z), or 0 */
+#endif
 
 /*
- * Samsung Remote Codes :
+ * Return the next edge without taking it. When the queue is empty a
+ * whole batch is read from the kernel, timestamped where it happened.
+ * Returns 0 if timeout_ms (< 0 is forever) passes without an edge.
  */
-#define IR_POWER	0xE0E040BF
-#define IR_0		0xE0E08877
-#define IR_1		0xE0E020DF
-#define IR_2		0xE0E0A05F
-#define IR_3		0xE0E0609F
-#define IR_4		0xE0E010EF
-#define IR_5		0xE0E0906F
-#define IR_6		0xE0E050AF
-#define IR_7		0xE0E030CF
-#define IR_8		0xE0E0B04F
-#define IR_9		0xE0E0708F
-#define IR_EXIT		0xE0E0B44B
-#define IR_RETURN	0xE0E01AE5
-#define IR_MUTE		0xE0E0F00F
-
-static struct {
-	unsigned long	ir_code;	/* IR Code */
-	const char 	*text;		/* Display text */
-} ir_codes[] = {
-	{ IR_POWER,	"\n<POWER>\n" },
-	{ IR_0, 	"0" },
-	{ IR_1, 	"1" },
-	{ IR_2, 	"2" },
-	{ IR_3, 	"3" },
-	{ IR_4, 	"4" },
-	{ IR_5, 	"5" },
-	{ IR_6, 	"6" },
-	{ IR_7, 	"7" },
-	{ IR_8, 	"8" },
-	{ IR_9, 	"9" },
-	{ IR_EXIT,	"\n<EXIT>\n" },
-	{ IR_RETURN,	"\n<RETURN>\n" },
-	{ IR_MUTE,	"\n<MUTE>\n" },
-	{ 0, 		0 }		/* End marker */
-};
+static gpio_edge_t *
+peek_edge(int timeout_ms) {
+	int rc;
 
-/*
- * Compute the time difference in milliseconds:
- */
-static double
-msdiff(struct timeval *t1,struct timeval *t0) {
-	unsigned long ut;
-	double ms;
-
-	ms = (t1->tv_sec - t0->tv_sec) * 1000.0;
-	if ( t1->tv_usec > t0->tv_usec )
-		ms += (t1->tv_usec - t0->tv_usec) / 1000.0;
-	else	{
-		ut = t1->tv_usec + 1000000UL;
-		ut -= t0->tv_usec;
-		ms += ut / 1000.0;
+	while ( !ir_count ) {
+		rc = gpio_line_wait(ir_line,ir_queue,IR_BATCH,timeout_ms);
+		if ( is_signaled )
+			longjmp(jmp_exit,1);
+		if ( rc > 0 ) {
+			if ( ir_rec )
+				edge_rec_put(ir_rec,ir_queue,rc);
+			ir_head = 0;
+			ir_count = rc;
+		} else if ( !rc ) {
+			return 0;		/* Timed out */
+		} else if ( errno != EINTR ) {
+			perror("gpio_line_wait()");
+			longjmp(jmp_exit,1);
+		}
 	}
-	return ms;
+	return &ir_queue[ir_head];
 }
 
 /*
- * Create a pathname for type in buf.
+ * Take the edge returned by peek_edge() :
  */
-static const char *
-gpio_setpath(int pin,gpio_path_t type,char *buf,unsigned bufsiz) {
-	static const char *paths[] = {
-		"export", "unexport", "gpio%d/direction",
-		"gpio%d/edge", "gpio%d/value" };
-	int slen;
-
-	strncpy(buf,"/sys/class/gpio/",bufsiz);
-	bufsiz -= (slen = strlen(buf));
-	snprintf(buf+slen,bufsiz,paths[type],pin);
-	return buf;
+static inline void
+take_edge(void) {
+	++ir_head;
+	--ir_count;
 }
 
 /*
- * Open /sys/class/gpio%d/value for edge detection :
+ * This routine will block until the GPIO pin has changed
+ * value. The time since the previous change is returned
+ * in *ms.
  */
 static int
-gpio_open_edge(int pin,const char *edge) {
-	char buf[128];
-	FILE *f;
-	int fd;
-
-	/* Export pin : /sys/class/gpio/export */
-	gpio_setpath(pin,gp_export,buf,sizeof buf);
-	f = fopen(buf,"w");
-	assert(f);
-	fprintf(f,"%d\n",pin);
-	fclose(f);
-
-	/* Direction :	/sys/class/gpio%d/direction */
-	gpio_setpath(pin,gp_direction,buf,sizeof buf);
-	f = fopen(buf,"w");
-	assert(f);
-	fprintf(f,"in\n");
-	fclose(f);
-
-	/* Edge :	/sys/class/gpio%d/edge */
-	gpio_setpath(pin,gp_edge,buf,sizeof buf);
-	f = fopen(buf,"w");
-	assert(f);
-	fprintf(f,"%s\n",edge);
-	fclose(f);
-
-	/* Value :	/sys/class/gpio%d/value */
-	gpio_setpath(pin,gp_value,buf,sizeof buf);
-	fd = open(buf,O_RDWR);
-	return fd;
+gpio_poll(double *ms) {
+	gpio_edge_t *edge = peek_edge(-1);
+
+	take_edge();
+	*ms = last_ns ? (edge->ns - last_ns) / 1e6 : 0.0;
+	last_ns = edge->ns;		/* Save for next call */
+	return edge->level;		/* Return value */
 }
 
 /*
- * Close (unexport) GPIO pin :
+ * Signal handler to quit the program :
  */
 static void
-gpio_close(int pin) {
-	char buf[128];
-	FILE *f;
-
-	/* Unexport :	/sys/class/gpio/unexport */
-	gpio_setpath(pin,gp_unexport,buf,sizeof buf);
-	f = fopen(buf,"w");
-	assert(f);
-	fprintf(f,"%d\n",pin);
-	fclose(f);
+sigint_handler(int signo) {
+	is_signaled = 1;		/* Signal to exit program */
+}
+
+/*
+ * Wait until the line changes:
+ */
+static inline int
+wait_change(double *ms) {
+	/* Invert the logic of the input pin */
+	return gpio_poll(ms) ? 0 : 1;
+}
+
+/*
+ * CLOCK_MONOTONIC time in nanoseconds, as the edges are stamped :
+ */
+static unsigned long long
+mono_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Milliseconds from now until time ns, rounded up (0: forever) :
+ */
+static int
+wait_ms(unsigned long long ns) {
+	unsigned long long now;
+
+	if ( !ns )
+		return -1;
+	if ( (now = mono_ns()) >= ns )
+		return 0;
+	return (ns - now + 999999) / 1000000;
 }
 
 /*
- * This routine will block until the open GPIO pin has changed
- * value.
+ * Decode edges until a code completes, or time deadline (0: never)
+ * passes. Each period is fed to the decoders when the edge ending it
+ * is taken, so frames ending with a mark (NEC, Samsung) complete at
+ * their last edge. The others complete at the quiet gap that ends
+ * every frame, judged from the kernel timestamps so that a late
+ * wakeup cannot split a frame. Returns 1 with the code and the time
+ * of the frame's last edge, or 0 at the deadline.
  */
 static int
-gpio_poll(int fd,double *ms) {
-	static char needs_init = 1;
-	static struct timeval t0;
-	static struct timeval t1;
-	struct pollfd polls;
-	char buf[32];
-	int rc, n;
-	
-	if ( needs_init ) {
-		rc = gettimeofday(&t0,0);
-		assert(!rc);
-		needs_init = 0;
+get_code(ir_code_t *code,unsigned long long deadline,unsigned long long *ns) {
+	unsigned long long t_gap = 0, until;
+	gpio_edge_t *edge;
+	int got;
+
+	for (;;) {
+		until = deadline;
+		if ( in_frame ) {
+			t_gap = edge_ns + IR_GAP_MS * 1000000ULL;
+			if ( !until || t_gap < until )
+				until = t_gap;
+		}
+		edge = peek_edge(wait_ms(until));
+
+		*ns = edge_ns;
+		if ( in_frame && (edge ? edge->ns : mono_ns()) >= t_gap ) {
+			in_frame = 0;		/* The gap ends the frame */
+			if ( ir_feed(ir_dec,!edge_level,IR_END_US,code) )
+				return 1;
+		}
+		if ( !edge ) {
+			if ( deadline && mono_ns() >= deadline )
+				return 0;
+			continue;
+		}
+
+		/* The period before this edge, IR present when low */
+		got = in_frame && ir_feed(ir_dec,!edge_level,(edge->ns - edge_ns) / 1000,code);
+		edge_ns = edge->ns;
+		edge_level = edge->level;
+		in_frame = 1;
+		take_edge();
+		if ( got ) {
+			*ns = edge_ns;
+			return 1;
+		}
 	}
+}
 
-	polls.fd = fd;			/* /sys/class/gpio17/value */
-	polls.events = POLLPRI;		/* Exceptions */
-	
-	do	{
-		rc = poll(&polls,1,-1);	/* Block */
-		if ( is_signaled )
-			longjmp(jmp_exit,1);
-	} while ( rc < 0 && errno == EINTR );
-	
-	assert(rc > 0);
+/*
+ * Get the next key event. Repeats and releases fall due while
+ * waiting for edges, so they never hold up decoding.
+ */
+static ir_event_t
+getevent(void) {
+	static ir_event_t evs[IR_MAX_EVENTS];
+	static unsigned nev = 0, ex = 0;
+	unsigned long long ns;
+	ir_code_t code;
+
+	while ( ex >= nev ) {
+		ex = 0;
+		if ( (nev = ir_repeat_poll(&ir_rep,mono_ns(),evs)) != 0 )
+			break;
+		if ( get_code(&code,ir_repeat_deadline(&ir_rep),&ns) )
+			nev = ir_repeat_code(&ir_rep,&code,ns,evs);
+	}
+	return evs[ex++];
+}
 
-	rc = gettimeofday(&t1,0);
-	assert(!rc);
+/*
+ * Name the key of an event (0 if unmapped), logging new presses :
+ */
+static const char *
+event_key(const ir_event_t *ev) {
+	const ir_code_t *code = &ev->code;
 
-	*ms = msdiff(&t1,&t0);
+	if ( ev->value == IR_PRESS )
+		fprintf(stderr,"CODE %s 0x%0*X\n",ir_proto_name(code->proto),
+			code->proto == ir_samsung ? 8 : 4,code->scancode);
+	return ir_keymap_find(ir_map,code->proto,code->scancode);
+}
 
-	lseek(fd,0,SEEK_SET);
-	n = read(fd,buf,sizeof buf);	/* Read value */
-	assert(n>0);
-	buf[n] = 0;
+/*
+ * Get the next event of a mapped key, returning its name :
+ */
+static const char *
+getkey(ir_event_t *ev) {
+	const char *key;
 
-	rc = sscanf(buf,"%d",&n);
-	assert(rc==1);
+	for (;;) {
+		*ev = getevent();
+		if ( (key = event_key(ev)) != 0 )
+			return key;
+	}
+}
 
-	t0 = t1;			/* Save for next call */
-	return n;			/* Return value */
+/*
+ * Display a key :
+ */
+static void
+putkey(const char *key) {
+	if ( !key[1] )
+		fputs(key,stdout);		/* Digits etc. */
+	else	printf("\n<%s>\n",key);
+	fflush(stdout);
 }
 
 /*
- * Signal handler to quit the program :
+ * Post a key event as a Linux key event and publish it, as
+ * key:NAME, repeat:NAME or release:NAME :
  */
 static void
-sigint_handler(int signo) {
-	is_signaled = 1;		/* Signal to exit program */
+post_key(const char *key,int value) {
+	int kc;
+#ifdef IR_ZMQ
+	static const char *topics[] = { "release", "key", "repeat" };
+	char buf[80];
+	int n;
+#endif
+
+	if ( uinput_fd >= 0 && (kc = ir_keycode(key)) >= 0 ) {
+		uinput_key(uinput_fd,kc,value);
+		uinput_syn(uinput_fd);
+	}
+#ifdef IR_ZMQ
+	if ( publisher ) {
+		n = snprintf(buf,sizeof buf,"%s:%s",topics[value],key);
+		zmq_send(publisher,buf,n,0);
+	}
+#endif
 }
 
 /*
- * Wait until the line changes:
+ * Open the uinput device with every key that has a KEY_* code :
  */
-static inline int
-wait_change(double *ms) {
-	/* Invert the logic of the input pin */
-	return gpio_poll(gpio_fd,ms) ? 0 : 1;
+static int
+open_uinput(void) {
+	unsigned codes[128];
+
+	uinput_fd = uinput_open("irdecode",codes,ir_keycodes(codes,128),0);
+	return uinput_fd < 0 ? -1 : 0;
 }
 
 /*
- * Wait until line changes to "level" :
+ * Open the ZMQ publishing socket :
  */
 static int
-wait_level(int level) {
-	int v;
-	double ms;
+open_publisher(const char *endpoint) {
+#ifdef IR_ZMQ
+	zmq_context = zmq_ctx_new();
+	assert(zmq_context);
+	publisher = zmq_socket(zmq_context,ZMQ_PUB);
+	assert(publisher);
+	if ( zmq_bind(publisher,endpoint) ) {
+		fprintf(stderr,"%s: zmq_bind(%s)\n",zmq_strerror(errno),endpoint);
+		return -1;
+	}
+	return 0;
+#else
+	fprintf(stderr,"-z %s: irdecode was built without libzmq\n",endpoint);
+	return -1;
+#endif
+}
 
-	while ( (v = wait_change(&ms)) != level )
-		;
-	return v;
+/*
+ * Display the key of a recorded event, unless a release :
+ */
+static void
+show_event(const ir_event_t *ev) {
+	const char *key = event_key(ev);
+
+	if ( key && ev->value != IR_RELEASE )
+		putkey(key);
 }
 
 /*
- * Get a 32 bit code from remote control:
+ * Decode a recording at full speed, returning the frames decoded.
+ * Key presses and repeats are displayed unless quiet, with the time
+ * taken from the recording.
  */
-static unsigned long
-getword(void) {
-	static struct timeval t0 = { 0, 0 };
-	static unsigned long last = 0;
-	struct timeval t1;
-	double ms;
-	int v, b, count;
-	unsigned long word = 0;
-
-Start:	word = 0;
-	count = 0;
+static unsigned
+replay(const ir_period_t *periods,unsigned n,int quiet) {
+	ir_event_t evs[IR_MAX_EVENTS];
+	unsigned long long ns = 0;
+	unsigned x, e, nev, frames = 0;
+	ir_code_t code;
+	int got;
+
+	ir_reset(ir_dec);
+	ir_repeat_init(&ir_rep,rep_delay,rep_rate);
+	for ( x=0; x<=n; ++x ) {
+		if ( x < n ) {
+			got = ir_feed(ir_dec,periods[x].mark,periods[x].us,&code);
+			ns += periods[x].us * 1000ULL;
+		} else	got = ir_feed(ir_dec,0,IR_END_US,&code);
+
+		while ( ir_repeat_poll(&ir_rep,ns,evs) )
+			if ( !quiet )
+				show_event(&evs[0]);
+		if ( !got )
+			continue;
+		++frames;
+		nev = ir_repeat_code(&ir_rep,&code,ns,evs);
+		for ( e=0; e<nev && !quiet; ++e )
+			show_event(&evs[e]);
+	}
+	return frames;
+}
 
-	/*
-	 * Wait for a space of 46 ms :
-	 */
-	do	{
-		v = wait_change(&ms);
-	} while ( ms < 46.5 );
+static const ir_period_t *lat_periods;	/* Recording played (-L) */
+static unsigned lat_n;
 
-	/*
-	 * Wait for start: 4.5ms high, then 4.5ms low :
-	 */
-	for ( v=1;;) {
-		if ( v )
-			v = wait_level(0);
-		v = wait_level(1);
-		v = wait_change(&ms);	/* High to Low */
-		if ( !v && ms >= 4.0 && ms <= 5.0 ) {
-			v = wait_change(&ms);
-			if ( v && ms >= 4.0 && ms <= 5.0 )
-				break;
+/*
+ * Play the recording on the simulated line in real time, then leave
+ * a second for the last release and stop the decoding loop. Edges
+ * are stamped with the time they were due, as the kernel would.
+ */
+static void *
+lat_feeder(void *arg) {
+	struct timespec ts;
+	unsigned long long t = mono_ns() + 10000000ULL;
+	unsigned x;
+	int level = 1, next;
+
+	for ( x=0; x<=lat_n; ++x ) {
+		next = x < lat_n ? !lat_periods[x].mark : 1;
+		if ( next != level ) {
+			ts.tv_sec = t / 1000000000ULL;
+			ts.tv_nsec = t % 1000000000ULL;
+			clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,0);
+			gpio_line_sim_edge(ir_line,level = next,t);
 		}
+		if ( x < lat_n )
+			t += lat_periods[x].us * 1000ULL;
 	}
-				
-	/*
-	 * Get 32 bit code :
-	 */
-	do	{
-		/* Wait for line to go low */
-		v = wait_change(&ms);
-		if ( v || ms < 0.350 || ms > 0.8500 )
-			goto Start;
-
-		/* Wait for line to go high */
-		v = wait_change(&ms);
-		if ( !v || ms < 0.350 || ms > 2.0 )
-			goto Start;
+	sleep(1);
+	is_signaled = 1;
+	gpio_line_sim_edge(ir_line,level ^ 1,0);	/* Wake the loop */
+	return 0;
+}
 
-		b =  ms < 1.000 ? 0 : 1;
-		word = (word << 1) | b;
-	} while ( ++count < 32 );
+static int
+cmp_ull(const void *a,const void *b) {
+	unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
 
-	/*
-	 * Eliminate key stutter :
-	 */
-	gettimeofday(&t1,0);
-	if ( word == last && t0.tv_sec && msdiff(&t1,&t0) < 1100.0 )
-		goto Start;		/* Too soon */
+	return x < y ? -1 : x > y;
+}
 
-	t0 = t1;
-	fprintf(stderr,"CODE %08lX\n",word); 
-	return word;
+/*
+ * Latency benchmark (-L) : decode the recording as it is played on
+ * the simulated line, timing each event from when it was due (the
+ * last edge of a press's frame, or the time a repeat or release was
+ * scheduled) until getevent() returns it.
+ */
+static int
+latency_bench(const char *path,int noinvert) {
+	static const char *names[] = { "release", "press", "repeat" };
+	static unsigned long long lat[3][IR_MAX_LAT];
+	unsigned counts[3] = { 0, 0, 0 };
+	ir_period_t *periods;
+	unsigned long long *l, sum;
+	ir_event_t ev;
+	pthread_t tid;
+	unsigned n, v, x;
+
+	if ( ir_file_load(path,noinvert,&periods,&n) )
+		return 1;
+	lat_periods = periods;
+	lat_n = n;
+
+	setenv("GPIO_LINE","sim",1);
+	if ( !(ir_line = gpio_line_input(gpio_inpin,GPIO_EV_BOTH,0)) )
+		return 1;
+	ir_repeat_init(&ir_rep,rep_delay,rep_rate);
+
+	printf("Playing %u periods from %s (autorepeat %u,%u ms):\n",n,path,rep_delay,rep_rate);
+	pthread_create(&tid,0,lat_feeder,0);
+	if ( !setjmp(jmp_exit) )
+		for (;;) {
+			ev = getevent();
+			if ( counts[ev.value] < IR_MAX_LAT )
+				lat[ev.value][counts[ev.value]++] = mono_ns() - ev.ns;
+		}
+	pthread_join(tid,0);
+	gpio_line_close(ir_line);
+
+	for ( v=IR_PRESS; v<=IR_REPEAT+1; ++v ) {
+		x = v % 3;			/* press, repeat, release */
+		if ( !counts[x] ) {
+			printf("%-8s none\n",names[x]);
+			continue;
+		}
+		l = lat[x];
+		qsort(l,counts[x],sizeof *l,cmp_ull);
+		for ( sum=0, n=0; n<counts[x]; ++n )
+			sum += l[n];
+		printf("%-8s %4u events, latency us: min %.1f avg %.1f median %.1f p99 %.1f max %.1f\n",
+			names[x],counts[x],l[0] / 1e3,sum / 1e3 / counts[x],l[counts[x]/2] / 1e3,
+			l[counts[x] * 99 / 100] / 1e3,l[counts[x]-1] / 1e3);
+	}
+	free(periods);
+	return 0;
 }
 
 /*
- * Get text form of remote key :
+ * Convert a loaded recording to edges (-f with -w). The line is low
+ * during marks.
  */
-static const char *
-getircode(void) {
-	unsigned long code;
-	int kx;
+static void
+record_periods(const ir_period_t *periods,unsigned n) {
+	gpio_edge_t edge;
+	unsigned x;
+
+	edge.ns = 1000000000ULL;
+	edge.gpio = gpio_inpin;
+	edge.level = 1;				/* Idle */
+	for ( x=0; x<n; ++x ) {
+		if ( periods[x].mark == edge.level ) {	/* Level changes */
+			edge.level = !periods[x].mark;
+			while ( !edge_rec_put(ir_rec,&edge,1) )
+				usleep(1000);	/* Let the writer catch up */
+		}
+		edge.ns += periods[x].us * 1000ULL;
+	}
+}
 
-	for (;;) {
-		code = getword();
-		for ( kx=0; ir_codes[kx].text; ++kx )
-			if ( ir_codes[kx].ir_code == code )
-				return ir_codes[kx].text;
+/*
+ * Decode a recording, or benchmark decoding it :
+ */
+static int
+decode_file(const char *path,int noinvert,unsigned passes) {
+	struct timespec t0, t1;
+	ir_period_t *periods;
+	unsigned n, x, frames = 0;
+	double secs;
+
+	if ( ir_file_load(path,noinvert,&periods,&n) )
+		return 1;
+
+	if ( ir_rec )
+		record_periods(periods,n);
+
+	if ( !passes ) {
+		printf("Decoding %u periods from %s:\n",n,path);
+		frames = replay(periods,n,0);
+		printf("\n%u frames decoded.\n",frames);
+	} else	{
+		clock_gettime(CLOCK_MONOTONIC,&t0);
+		for ( x=0; x<passes; ++x )
+			frames += replay(periods,n,1);
+		clock_gettime(CLOCK_MONOTONIC,&t1);
+		secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		printf("%u passes of %u periods: %u frames in %.3f s\n",passes,n,frames,secs);
+		printf("%.0f frames/sec, %.0f periods/sec\n",frames / secs,(double)n * passes / secs);
 	}
+	free(periods);
+	return 0;
 }
 
 /*
@@ -320,46 +536,141 @@ getircode(void) {
  */
 int
 main(int argc,char **argv) {
-	const char *key;
-	int optch;
-	int f_dump = 0, f_gnuplot = 0, f_noinvert = 0;
-
-	while ( (optch = getopt(argc,argv,"dgnsp:h")) != EOF )
+	const char *key, *keymap = 0, *infile = 0, *recfile = 0, *endpoint = 0;
+	const char *rt_arg = 0;
+	unsigned passes = 0;
+	ir_event_t ev;
+	int optch, rc;
+	int f_dump = 0, f_noinvert = 0, f_daemon = 0, f_uinput = 0, f_latency = 0;
+
+	while ( (optch = getopt(argc,argv,"dnsk:f:w:b:La:p:R:Duz:h")) != EOF )
 		switch ( optch ) {
 		case 'd' :
 			f_dump = 1;
 			break;
-		case 'g' :
-			f_gnuplot = 1;
-			break;
 		case 'n' :
 			f_noinvert = 1;
 			break;
+		case 'k' :
+			keymap = optarg;
+			break;
+		case 'f' :
+			infile = optarg;
+			break;
+		case 'w' :
+			recfile = optarg;
+			break;
+		case 'b' :
+			passes = strtoul(optarg,0,10);
+			break;
+		case 'L' :
+			f_latency = 1;
+			break;
+		case 'a' :
+			rep_rate = rep_delay = 0;
+			sscanf(optarg,"%u,%u",&rep_delay,&rep_rate);
+			if ( rep_delay && !rep_rate )
+				rep_rate = 125;
+			break;
 		case 'p' :
 			gpio_inpin = atoi(optarg);
 			break;
+		case 'R' :
+			rt_arg = optarg;	/* Real-time CPU[,priority] */
+			break;
+		case 'D' :
+			f_daemon = 1;
+			break;
+		case 'u' :
+			f_uinput = 1;
+			break;
+		case 'z' :
+			endpoint = optarg;
+			break;
 		case 'h' :
 			/* Fall thru */
 		default :
 usage:			fprintf(stderr,
-				"Usage: %s [-d] [-g] [-n] [-p gpio]\n",argv[0]);
+				"Usage: %s [-d] [-n] [-k keymap] [-a delay[,rate]] [-f file [-b n|-L]] [-w file]\n"
+				"\t[-p gpio] [-R cpu[,prio]] [-D] [-u] [-z endpoint]\n",argv[0]);
 			fputs("where:\n"
 				"  -d\t\tdumps events\n"
-				"  -g\t\tgnuplot waveforms\n"
 				"  -n\t\tdon't invert GPIO input\n"
-				"  -p gpio\tGPIO pin to use (17)\n",
+				"  -k keymap\tkeymap file (Samsung remote)\n"
+				"  -a delay,rate\tautorepeat ms, 0 for none (500,125)\n"
+				"  -f file\tdecode a recording instead of the GPIO\n"
+				"  -b n\t\tbenchmark: decode the recording n times\n"
+				"  -L\t\tbenchmark: event latency, playing it in real time\n"
+				"  -w file\trecord edges (edgeexport makes VCD or CSV)\n"
+				"  -p gpio\tGPIO pin to use (17)\n"
+				"  -R cpu[,prio]\treal-time CPU and priority\n"
+				"  -D\t\trun as a daemon (needs -u or -z)\n"
+				"  -u\t\tpost key events on a uinput device\n"
+				"  -z endpoint\tpublish keys on ZMQ, e.g. tcp://*:9998\n",
 				stderr);
 			exit(1);
 		}
 
-	if ( gpio_inpin < 0 || gpio_inpin >= 32 )
+	if ( gpio_inpin < 0 || gpio_inpin >= GPIO_COUNT )
+		goto usage;
+	if ( f_daemon && !f_uinput && !endpoint )
 		goto usage;
 
+	if ( keymap ) {
+		if ( !(ir_map = ir_keymap_load(keymap)) )
+			return 1;
+	} else	ir_map = ir_keymap_default();
+	ir_dec = ir_decoder_new();
+
+	/*
+	 * Fork now: threads (recorder, ZMQ) and mlockall() do not
+	 * survive into the child. The cwd is kept for -w.
+	 */
+	if ( f_daemon && !infile && daemon(1,0) ) {
+		perror("daemon()");
+		return 1;
+	}
+	if ( rt_arg )
+		rt_optarg(rt_arg);
+
+	if ( recfile && !(ir_rec = edge_rec_open(recfile)) )
+		return 1;
+
+	if ( infile ) {
+		if ( f_latency )
+			rc = latency_bench(infile,f_noinvert);
+		else	rc = decode_file(infile,f_noinvert,passes);
+		if ( ir_rec )
+			edge_rec_close(ir_rec);
+		ir_decoder_free(ir_dec);
+		ir_keymap_free(ir_map);
+		return rc;
+	}
+
 	if ( setjmp(jmp_exit) )
 		goto xit;
 
 	signal(SIGINT,sigint_handler);			/* Trap on SIGINT */
-	gpio_fd = gpio_open_edge(gpio_inpin,"both");	/* GPIO input */
+	signal(SIGTERM,sigint_handler);
+	ir_line = gpio_line_input(gpio_inpin,GPIO_EV_BOTH,0); /* GPIO input */
+	if ( !ir_line )
+		return 1;
+
+	ir_repeat_init(&ir_rep,rep_delay,rep_rate);
+	if ( f_uinput && open_uinput() )
+		return 1;
+	if ( endpoint && open_publisher(endpoint) )
+		return 1;
+
+	if ( f_daemon ) {
+		/*
+		 * Daemon read loop :
+		 */
+		for (;;) {
+			key = getkey(&ev);
+			post_key(key,ev.value);
+		}
+	}
 
 	printf("Monitoring GPIO %d for changes:\n",gpio_inpin);
 
@@ -368,37 +679,45 @@ usage:			fprintf(stderr,
 		 * Remote control read loop :
 		 */
 		for (;;) {
-			key = getircode();
-			fputs(key,stdout);
-			if ( !strcmp(key,"\n<EXIT>\n") )
+			key = getkey(&ev);
+			post_key(key,ev.value);
+			if ( ev.value == IR_RELEASE )
+				continue;
+			putkey(key);
+			if ( ev.value == IR_PRESS && !strcmp(key,"EXIT") )
 				break;
-			fflush(stdout);
 		}
 	} else	{
 		/*
 		 * Dump out IR level changes
 		 */
 		int v;
-		double ms, t=0.0;
+		double ms;
 
 		wait_change(&ms);		/* Wait for first change */
 
 		for (;;) {
 			v = wait_change(&ms) ^ f_noinvert;
-			if ( !f_gnuplot )
-				printf("%12.3f\t%d\n",ms,v);
-			else	{
-				printf("%12.3f\t%d\n",t,v^1);
-				t += ms;
-				printf("%12.3f\t%d\n",t,v^1);
-				printf("%12.3f\t%d\t%12.3f\n",t,v,ms);
-			}
+			printf("%12.3f\t%d\n",ms,v);
 		}
 	}
 
-xit:	fputs("\nExit.\n",stdout);
-	close(gpio_fd);				/* Close gpio%d/value */
-	gpio_close(gpio_inpin);			/* Unexport gpio */
+xit:	if ( !f_daemon )
+		fputs("\nExit.\n",stdout);
+	gpio_line_close(ir_line);		/* Release (unexport) gpio */
+	if ( uinput_fd >= 0 )
+		uinput_close(uinput_fd);
+#ifdef IR_ZMQ
+	if ( publisher ) {
+		zmq_send(publisher,"off:",4,0);
+		zmq_close(publisher);
+		zmq_ctx_destroy(zmq_context);
+	}
+#endif
+	if ( ir_rec )
+		edge_rec_close(ir_rec);
+	ir_decoder_free(ir_dec);
+	ir_keymap_free(ir_map);
 	return 0;
 }
 
@@ -0,0 +1,271 @@
+/*********************************************************************
+ * irsend.c : Send IR remote control codes (IR LED driver on GPIO 18)
+ *
+ * ./irsend [-k keymap] [-c hz] [-D duty] [-r repeats] [-w file]
+ *	[-R cpu[,prio]] key ...
+ *
+ * The hardware PWM generates the carrier in mark-space mode and is
+ * switched on for marks and off for spaces. Each frame is encoded
+ * (ir_encode()) and turned into a schedule of absolute switching
+ * times before the first edge, so sending is a loop of clock reads
+ * and one register write per edge. A frame that falls behind the
+ * schedule by more than -t us (a preemption) is cut off and sent
+ * again a frame period later.
+ *
+ * A key is a name from the keymap (as used by irdecode), or
+ * protocol:scancode, e.g. nec:0x0412. -w records what was sent for
+ * irdecode -f.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
+#include "gpio_time.h"			/* gpio_ns() (libgpio) */
+#include "pwm_io.h"			/* PWM routines (libgpio) */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
+#include "ir_proto.h"			/* IR protocol encoders */
+#include "ir_keymap.h"			/* Key names to codes */
+#include "ir_file.h"			/* Recording what was sent */
+
+#define MAX_PERIODS	128		/* Longest frame */
+#define MAX_TRIES	5		/* Attempts at sending a frame */
+
+static FILE *rec_file = 0;		/* -w recording, or 0 */
+static unsigned long long rec_ns = 0;	/* End of the last period recorded */
+
+/*
+ * Choose the PWM clock divisor and range closest to the carrier
+ * frequency, and set it up stopped. Returns the frequency achieved.
+ */
+static double
+carrier_setup(unsigned hz,unsigned duty) {
+	unsigned idiv, m, best_div = 2, best_m = 0;
+	double f, err, best_err = 1e30;
+
+	for ( idiv=2; idiv<0x1000; ++idiv ) {
+		m = (unsigned)(PWM_CLOCK_HZ / idiv / hz + 0.5);
+		if ( m < 10 )
+			break;			/* Too coarse for the duty cycle */
+		f = PWM_CLOCK_HZ / idiv / m;
+		err = f > hz ? f - hz : hz - f;
+		if ( err < best_err ) {
+			best_err = err;
+			best_div = idiv;
+			best_m = m;
+		}
+	}
+	if ( !best_m )
+		return 0.0;
+
+	/* pwm_frequency() truncates the divisor: ask between two */
+	pwm_frequency(PWM_CLOCK_HZ / (best_div + 0.5));
+	pwm_markspace(1);
+	pwm_ratio((best_m * duty + 50) / 100,best_m);
+	pwm_enable(0);
+	return PWM_CLOCK_HZ / best_div / best_m;
+}
+
+/*
+ * Send one frame starting at time t0, storing the time of each of
+ * the n+1 switches made in when[], and the worst lateness in *worst.
+ * Returns n, or the number of periods sent before the frame was cut
+ * off for being more than max_late ns late.
+ */
+static unsigned
+send_frame(const ir_period_t *periods,unsigned n,unsigned long long t0,
+  unsigned long long max_late,unsigned long long *when,unsigned long long *worst) {
+	unsigned long long due[MAX_PERIODS+1], now, late;
+	unsigned x;
+
+	due[0] = t0;
+	for ( x=0; x<n; ++x )
+		due[x+1] = due[x] + periods[x].us * 1000ULL;
+
+	if ( (now = gpio_ns()) < t0 )
+		gpio_delay_ns(t0 - now);	/* Sleeps for most of a gap */
+
+	*worst = 0;
+	for ( x=0; x<=n; ++x ) {
+		while ( gpio_ns() < due[x] )
+			;
+		pwm_enable(x < n && periods[x].mark);
+		when[x] = gpio_ns();
+
+		if ( (late = when[x] - due[x]) > *worst )
+			*worst = late;
+		if ( late > max_late && x < n ) {
+			pwm_enable(0);		/* Cut off */
+			when[x] = gpio_ns();
+			return x;
+		}
+	}
+	return n;
+}
+
+/*
+ * Record the periods as sent (-w) :
+ */
+static void
+record(const ir_period_t *periods,unsigned n,const unsigned long long *when) {
+	unsigned x;
+
+	if ( rec_ns )
+		ir_file_put(rec_file,0,(when[0] - rec_ns) / 1000);
+	for ( x=0; x<n; ++x )
+		ir_file_put(rec_file,periods[x].mark,(when[x+1] - when[x]) / 1000);
+	rec_ns = when[n];
+}
+
+/*
+ * Look up a key name, or parse protocol:scancode :
+ */
+static int
+key_code(const ir_keymap_t *map,const char *key,ir_code_t *code) {
+	char name[32], *ep;
+	const char *cp;
+	int p;
+
+	memset(code,0,sizeof *code);
+	if ( !ir_keymap_code(map,key,&code->proto,&code->scancode) )
+		return 0;
+
+	if ( (cp = strchr(key,':')) != 0 && cp - key < (int)sizeof name ) {
+		memcpy(name,key,cp-key);
+		name[cp-key] = 0;
+		if ( (p = ir_proto_lookup(name)) >= 0 ) {
+			code->proto = (ir_proto_t)p;
+			code->scancode = strtoul(cp+1,&ep,0);
+			if ( cp[1] && !*ep )
+				return 0;
+		}
+	}
+	fprintf(stderr,"Unknown key '%s'\n",key);
+	return -1;
+}
+
+/*
+ * Main program :
+ */
+int
+main(int argc,char **argv) {
+	static ir_period_t periods[MAX_PERIODS];
+	unsigned long long when[MAX_PERIODS+1], t0 = 0, worst;
+	const char *keymap = 0, *recfile = 0;
+	unsigned hz = 38000, duty = 33, repeats = 0, max_late_us = 100, r, sent, tries;
+	ir_keymap_t *map;
+	ir_code_t code;
+	int optch, n, toggle = 0;
+	double carrier;
+
+	while ( (optch = getopt(argc,argv,"k:c:D:r:t:w:R:h")) != EOF )
+		switch ( optch ) {
+		case 'k' :
+			keymap = optarg;
+			break;
+		case 'c' :
+			hz = strtoul(optarg,0,10);
+			break;
+		case 'D' :
+			duty = strtoul(optarg,0,10);
+			break;
+		case 'r' :
+			repeats = strtoul(optarg,0,10);
+			break;
+		case 't' :
+			max_late_us = strtoul(optarg,0,10);
+			break;
+		case 'w' :
+			recfile = optarg;
+			break;
+		case 'R' :
+			rt_optarg(optarg);	/* Real-time CPU[,priority] */
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,
+				"Usage: %s [-k keymap] [-c hz] [-D duty] [-r repeats] [-t us]\n"
+				"\t[-w file] [-R cpu[,prio]] key ...\n",argv[0]);
+			fputs("where:\n"
+				"  -k keymap\tkeymap file (Samsung remote)\n"
+				"  -c hz\t\tcarrier frequency (38000)\n"
+				"  -D duty\tcarrier duty cycle percent (33)\n"
+				"  -r repeats\tframes sent after the first, as if held (0)\n"
+				"  -t us\t\tlateness that cuts a frame off (100)\n"
+				"  -w file\trecord what was sent (for irdecode -f)\n"
+				"  -R cpu[,prio]\treal-time CPU and priority\n"
+				"  key\t\tkeymap name, or protocol:scancode\n",
+				stderr);
+			return 1;
+		}
+
+	if ( optind >= argc || hz < 10000 || hz > 100000 || duty < 1 || duty > 99 )
+		goto usage;
+
+	if ( keymap ) {
+		if ( !(map = ir_keymap_load(keymap)) )
+			return 1;
+	} else	map = ir_keymap_default();
+
+	if ( recfile && !(rec_file = ir_file_create(recfile)) )
+		return 1;
+
+	gpio_time_init();
+	if ( pwm_init() )
+		return 1;
+	carrier = carrier_setup(hz,duty);
+	printf("Carrier %.1f Hz, %u%% duty\n",carrier,duty);
+
+	for ( ; optind < argc; ++optind ) {
+		if ( key_code(map,argv[optind],&code) )
+			continue;
+		code.toggle = toggle;
+
+		/* Time to settle, but keep the frame period after the last key */
+		if ( t0 < gpio_ns() + 1000000 )
+			t0 = gpio_ns() + 1000000;
+		for ( r=0; r<=repeats; ++r ) {
+			code.repeat = r > 0;	/* NEC sends repeat frames */
+			if ( (n = ir_encode(&code,periods,MAX_PERIODS)) < 0 ) {
+				fprintf(stderr,"%s: cannot send %s 0x%X\n",argv[optind],
+					ir_proto_name(code.proto),code.scancode);
+				break;
+			}
+			for ( tries=1;; ++tries ) {
+				sent = send_frame(periods,n,t0,max_late_us * 1000ULL,when,&worst);
+				if ( rec_file )
+					record(periods,sent,when);
+				t0 += ir_frame_us(code.proto) * 1000ULL;
+				if ( sent == n || tries >= MAX_TRIES )
+					break;
+				if ( t0 < gpio_ns() )
+					t0 = gpio_ns() + ir_frame_us(code.proto) * 1000ULL;
+			}
+			printf("%s %s 0x%X%s: %d periods in %.3f ms, worst error %.1f us",
+				argv[optind],ir_proto_name(code.proto),code.scancode,
+				code.repeat ? " (repeat)" : "",n,
+				(when[sent] - when[0]) / 1e6,worst / 1e3);
+			if ( sent < n )
+				printf(" FAILED after %u tries\n",tries);
+			else if ( tries > 1 )
+				printf(" (%u tries)\n",tries);
+			else	putchar('\n');
+		}
+		toggle ^= 1;			/* RC5/RC6: a new key press */
+	}
+
+	pwm_enable(0);
+	if ( rec_file )
+		fclose(rec_file);
+	ir_keymap_free(map);
+	return 0;
+}
+
+/*********************************************************************
+ * End irsend.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,209 @@
+/*********************************************************************
+ * dma_io.c : BCM2835 DMA channels and uncached memory (libgpio)
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "gpio_io.h"
+#include "dma_io.h"
+
+#define MBOX_DEVICE	"/dev/vcio"
+#define MBOX_PROPERTY	_IOWR(100,0,char *)
+#define MBOX_ALLOC	0x3000C		/* Allocate memory */
+#define MBOX_LOCK	0x3000D		/* Lock, returning the bus address */
+#define MBOX_UNLOCK	0x3000E
+#define MBOX_RELEASE	0x3000F
+
+#define MEM_FLAG_DIRECT	0x4		/* Uncached (0xC... alias) */
+#define MEM_FLAG_L1_NONALLOC 0xC	/* Uncached on the Pi 1 */
+
+#define PAGE		4096
+#define SIM_BUS		0xDE000000	/* Made up bus addresses (sim) */
+
+/*
+ * Internal : One mailbox property call with one tag. Returns the
+ * first word of the tag's answer, or ~0 on failure.
+ */
+static unsigned
+mbox_call(int fd,unsigned tag,unsigned n,unsigned a,unsigned b,unsigned c) {
+	unsigned msg[32] __attribute__((aligned(16)));
+	unsigned x = 0;
+
+	msg[x++] = 0;			/* Size, below */
+	msg[x++] = 0;			/* Request */
+	msg[x++] = tag;
+	msg[x++] = n * 4;		/* Value buffer bytes */
+	msg[x++] = n * 4;		/* Request bytes */
+	msg[x++] = a;
+	msg[x++] = b;
+	msg[x++] = c;
+	msg[x++] = 0;			/* End tag */
+	msg[0] = x * 4;
+
+	if ( ioctl(fd,MBOX_PROPERTY,msg) < 0 || msg[1] != 0x80000000 )
+		return ~0u;
+	return msg[5];
+}
+
+/*********************************************************************
+ * Allocate size bytes (rounded up to pages) of uncached memory for
+ * control blocks and data. Returns 0, or -1 (reported).
+ *********************************************************************/
+int
+dma_mem_alloc(dma_mem_t *mem,unsigned size) {
+	unsigned flags;
+	void *p;
+	int fd;
+
+	memset(mem,0,sizeof *mem);
+	mem->mbox = -1;
+	mem->size = (size + PAGE - 1) & ~(PAGE - 1);
+
+	if ( gpio_get_backend() == &gpio_backend_sim ) {
+		if ( posix_memalign(&p,PAGE,mem->size) ) {
+			perror("posix_memalign()");
+			return -1;
+		}
+		memset(p,0,mem->size);
+		mem->virt = p;
+		mem->bus = SIM_BUS;
+		return 0;
+	}
+
+	if ( (mem->mbox = open(MBOX_DEVICE,O_RDWR)) < 0 ) {
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),MBOX_DEVICE);
+		return -1;
+	}
+	flags = gpio_peri_base() == BCM2708_PERI_BASE ? MEM_FLAG_L1_NONALLOC : MEM_FLAG_DIRECT;
+	mem->handle = mbox_call(mem->mbox,MBOX_ALLOC,3,mem->size,PAGE,flags);
+	if ( mem->handle == ~0u || !mem->handle ) {
+		fprintf(stderr,"Mailbox: cannot allocate %u bytes of DMA memory\n",mem->size);
+		goto fail;
+	}
+	mem->bus = mbox_call(mem->mbox,MBOX_LOCK,1,mem->handle,0,0);
+	if ( mem->bus == ~0u || !mem->bus ) {
+		fputs("Mailbox: cannot lock DMA memory\n",stderr);
+		goto fail;
+	}
+
+	if ( (fd = open("/dev/mem",O_RDWR|O_SYNC)) < 0 ) {
+		perror("/dev/mem");
+		goto fail;
+	}
+	p = mmap(NULL,mem->size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,mem->bus & ~0xC0000000);
+	close(fd);
+	if ( p == MAP_FAILED ) {
+		perror("mmap(DMA memory)");
+		goto fail;
+	}
+	mem->virt = p;
+	memset(mem->virt,0,mem->size);
+	return 0;
+
+fail:	dma_mem_free(mem);
+	return -1;
+}
+
+/*********************************************************************
+ * Release DMA memory (stop the channel using it first)
+ *********************************************************************/
+void
+dma_mem_free(dma_mem_t *mem) {
+
+	if ( mem->mbox < 0 ) {
+		free(mem->virt);
+	} else	{
+		if ( mem->virt )
+			munmap(mem->virt,mem->size);
+		if ( mem->handle && mem->handle != ~0u ) {
+			mbox_call(mem->mbox,MBOX_UNLOCK,1,mem->handle,0,0);
+			mbox_call(mem->mbox,MBOX_RELEASE,1,mem->handle,0,0);
+		}
+		close(mem->mbox);
+	}
+	memset(mem,0,sizeof *mem);
+	mem->mbox = -1;
+}
+
+/*********************************************************************
+ * Translate between our addresses and the DMA engine's
+ *********************************************************************/
+unsigned
+dma_bus(const dma_mem_t *mem,const void *virt) {
+	return mem->bus + (unsigned)((const char *)virt - (const char *)mem->virt);
+}
+
+void *
+dma_virt(const dma_mem_t *mem,unsigned bus) {
+	if ( bus < mem->bus || bus - mem->bus >= mem->size )
+		return 0;
+	return (char *)mem->virt + (bus - mem->bus);
+}
+
+/*********************************************************************
+ * Map the registers of DMA channel chan (0-14) and enable it. The
+ * caller must hold a gpio_init() reference. Returns 0 on failure.
+ *********************************************************************/
+volatile unsigned *
+dma_channel(int chan) {
+	volatile unsigned *dmab;
+
+	if ( chan < 0 || chan >= DMA_CHANNELS ) {
+		fprintf(stderr,"DMA channel %d: use 0 to %d\n",chan,DMA_CHANNELS-1);
+		return 0;
+	}
+	if ( !(dmab = gpio_map_peri(DMA_OFFSET)) )
+		return 0;
+	PERI_WR(dmab,DMA_ENABLE,PERI_RD(dmab,DMA_ENABLE) | 1 << chan);
+	return dmab + chan * DMA_CHAN_WORDS;
+}
+
+/*********************************************************************
+ * Reset the channel and start it on the control block at cb_bus
+ *********************************************************************/
+void
+dma_start(volatile unsigned *dma,unsigned cb_bus) {
+
+	dma_stop(dma);
+	PERI_WR(dma,DMA_CONBLK_AD,cb_bus);
+	PERI_WR(dma,DMA_CS,DMA_CS_WAIT_WRITES|DMA_CS_PANIC(15)|DMA_CS_PRIORITY(8)|DMA_CS_ACTIVE);
+}
+
+/*********************************************************************
+ * Abort any transfer and reset the channel
+ *********************************************************************/
+void
+dma_stop(volatile unsigned *dma) {
+	int x;
+
+	if ( PERI_RD(dma,DMA_CS) & DMA_CS_ACTIVE ) {
+		PERI_WR(dma,DMA_CS,DMA_CS_ABORT);
+		for ( x=0; x<1000 && (PERI_RD(dma,DMA_CS) & DMA_CS_ABORT); ++x )
+			usleep(10);
+	}
+	PERI_WR(dma,DMA_CS,DMA_CS_RESET);
+	usleep(10);
+	PERI_WR(dma,DMA_CS,DMA_CS_INT|DMA_CS_END);	/* Clear flags */
+	PERI_WR(dma,DMA_CONBLK_AD,0);
+}
+
+/*********************************************************************
+ * True while the channel has blocks to run
+ *********************************************************************/
+int
+dma_busy(volatile unsigned *dma) {
+	return (PERI_RD(dma,DMA_CS) & DMA_CS_ACTIVE) != 0;
+}
+
+/*********************************************************************
+ * End dma_io.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,104 @@
+/*********************************************************************
+ * dma_io.h : BCM2835 DMA channels and uncached memory (libgpio)
+ *
+ * A DMA channel runs a chain of control blocks, each moving a block
+ * of words from memory to a peripheral (or back), paced by the
+ * peripheral's DREQ line, so a sample stream plays out with no CPU
+ * involvement. The control blocks and data must be in memory the
+ * VPU can see uncached: dma_mem_alloc() gets it from the firmware
+ * through the mailbox (/dev/vcio) and maps it with /dev/mem.
+ *
+ * With GPIO_BACKEND=sim the memory is ordinary memory with made up
+ * bus addresses (dma_virt() maps them back) and nothing moves, so
+ * the control blocks can be inspected.
+ *
+ * Stay off the channels the kernel uses (see dma-channel-mask in
+ * the device tree); DMA_CHANNEL is usually free. Channels 7 and up
+ * are "lite" channels, limited to DMA_LITE_MAX bytes per block.
+ *********************************************************************/
+
+#ifndef DMA_IO_H
+#define DMA_IO_H
+
+#define DMA_OFFSET	0x007000	/* DMA from PERI_BASE (channels 0-14) */
+#define DMA_CHAN_WORDS	0x40		/* Register words per channel */
+#define DMA_ENABLE	0x3FC		/* Global enable register (word) */
+#define DMA_CHANNELS	15		/* Channels mapped here */
+#define DMA_CHANNEL	10		/* Default channel */
+#define DMA_LITE_MAX	65532		/* Bytes per block on lite channels */
+
+#define DMA_PERI_BUS	0x7E000000	/* Peripherals, as DMA sees them */
+
+/*
+ * Channel register word indexes :
+ */
+#define DMA_CS		0		/* Control and status */
+#define DMA_CONBLK_AD	1		/* Control block address */
+#define DMA_TI		2		/* Current block: transfer info */
+#define DMA_SOURCE_AD	3
+#define DMA_DEST_AD	4
+#define DMA_TXFR_LEN	5
+#define DMA_STRIDE	6
+#define DMA_NEXTCONBK	7
+#define DMA_DEBUG	8
+
+/* DMA_CS bits */
+#define DMA_CS_ACTIVE	0x00000001
+#define DMA_CS_END	0x00000002
+#define DMA_CS_INT	0x00000004
+#define DMA_CS_ERROR	0x00000100
+#define DMA_CS_PRIORITY(n) ((n) << 16)
+#define DMA_CS_PANIC(n)	((n) << 20)
+#define DMA_CS_WAIT_WRITES 0x10000000
+#define DMA_CS_ABORT	0x40000000
+#define DMA_CS_RESET	0x80000000
+
+/* Control block TI bits */
+#define DMA_TI_INTEN	0x00000001
+#define DMA_TI_WAIT_RESP 0x00000008
+#define DMA_TI_DEST_INC	0x00000010
+#define DMA_TI_DEST_DREQ 0x00000040
+#define DMA_TI_SRC_INC	0x00000100
+#define DMA_TI_SRC_DREQ	0x00000400
+#define DMA_TI_PERMAP(n) ((n) << 16)
+#define DMA_TI_NO_WIDE	0x04000000
+
+#define DMA_DREQ_PWM	5		/* PWM FIFO pacing */
+
+typedef struct {			/* 32 byte aligned */
+	unsigned	ti;		/* Transfer information */
+	unsigned	source_ad;	/* Bus addresses */
+	unsigned	dest_ad;
+	unsigned	txfr_len;	/* Bytes */
+	unsigned	stride;
+	unsigned	nextconbk;	/* Next block, or 0 to stop */
+	unsigned	pad[2];
+} dma_cb_t;
+
+typedef struct {
+	void		*virt;		/* Where we see it */
+	unsigned	bus;		/* Where the DMA engine sees it */
+	unsigned	size;		/* Bytes (whole pages) */
+	unsigned	handle;		/* Firmware handle, or 0 */
+	int		mbox;		/* /dev/vcio, or -1 */
+} dma_mem_t;
+
+int dma_mem_alloc(dma_mem_t *mem,unsigned size);	/* 0 or -1 */
+void dma_mem_free(dma_mem_t *mem);
+unsigned dma_bus(const dma_mem_t *mem,const void *virt);
+void *dma_virt(const dma_mem_t *mem,unsigned bus);	/* Or 0 */
+
+volatile unsigned *dma_channel(int chan);	/* Registers, or 0 */
+void dma_start(volatile unsigned *dma,unsigned cb_bus);
+void dma_stop(volatile unsigned *dma);
+int dma_busy(volatile unsigned *dma);
+
+#define dma_peri_bus(offset,reg) (DMA_PERI_BUS + (offset) + (reg) * 4)
+
+#endif /* DMA_IO_H */
+
+/*********************************************************************
+ * End dma_io.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
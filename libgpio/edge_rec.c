@@ -0,0 +1,180 @@
+/*********************************************************************
+ * edge_rec.c : Binary recording of GPIO edges (libgpio)
+ *
+ * The ring indexes run freely: head counts edges put (producer) and
+ * tail edges written (consumer), so head - tail is the fill, as in
+ * logic.c.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "edge_rec.h"
+#include "user_file.h"
+
+#define EDGE_REC_MASK	(EDGE_REC_SLOTS - 1)
+
+struct edge_rec {
+	gpio_edge_t	*ring;		/* EDGE_REC_SLOTS edges */
+	unsigned	head;		/* Edges put (producer) */
+	unsigned	tail;		/* Edges written (consumer) */
+	unsigned	dropped;	/* Edges lost to a full ring */
+	int		done;		/* Close requested */
+	int		failed;		/* Write error (reported) */
+	unsigned long long written;	/* Edges written */
+	FILE		*f;		/* Recording */
+	pthread_t	tid;		/* Writer thread */
+};
+
+/*
+ * Internal : Writer thread, streaming the ring to the file in
+ * contiguous spans. Sleeps when the ring is empty.
+ */
+static void *
+writer(void *arg) {
+	edge_rec_t *rec = arg;
+	unsigned h, t, n;
+	int done;
+
+	for (;;) {
+		done = __atomic_load_n(&rec->done,__ATOMIC_ACQUIRE);
+		h = __atomic_load_n(&rec->head,__ATOMIC_ACQUIRE);
+		t = rec->tail;
+		if ( t == h ) {
+			if ( done )
+				break;
+			usleep(1000);
+			continue;
+		}
+
+		n = h - t;
+		if ( n > EDGE_REC_SLOTS - (t & EDGE_REC_MASK) )
+			n = EDGE_REC_SLOTS - (t & EDGE_REC_MASK);	/* To the ring's end */
+		if ( !rec->failed && fwrite(&rec->ring[t & EDGE_REC_MASK],sizeof *rec->ring,n,rec->f) != n ) {
+			perror("Writing edge recording");
+			rec->failed = 1;		/* Keep draining */
+		}
+		rec->written += n;
+		__atomic_store_n(&rec->tail,t+n,__ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+/*********************************************************************
+ * Create a recording and start its writer (0 on failure, reported)
+ *********************************************************************/
+edge_rec_t *
+edge_rec_open(const char *path) {
+	edge_rec_t *rec = calloc(1,sizeof *rec);
+
+	if ( !rec )
+		return 0;
+	if ( !(rec->ring = malloc(EDGE_REC_SLOTS * sizeof *rec->ring)) ) {
+		free(rec);
+		return 0;
+	}
+	memset(rec->ring,0,EDGE_REC_SLOTS * sizeof *rec->ring);	/* Pre-fault */
+
+	if ( !(rec->f = user_fopen(path,"w")) ) {
+		fprintf(stderr,"%s: creating %s\n",strerror(errno),path);
+		free(rec->ring);
+		free(rec);
+		return 0;
+	}
+	fwrite(EDGE_REC_MAGIC,1,8,rec->f);
+
+	if ( pthread_create(&rec->tid,0,writer,rec) ) {
+		perror("pthread_create()");
+		fclose(rec->f);
+		free(rec->ring);
+		free(rec);
+		return 0;
+	}
+	return rec;
+}
+
+/*********************************************************************
+ * Queue n edges for writing, without blocking. Returns the number
+ * queued; the rest are dropped for want of room.
+ *********************************************************************/
+unsigned
+edge_rec_put(edge_rec_t *rec,const gpio_edge_t *edges,unsigned n) {
+	unsigned h = rec->head, room, x;
+
+	room = EDGE_REC_SLOTS - (h - __atomic_load_n(&rec->tail,__ATOMIC_ACQUIRE));
+	if ( n > room ) {
+		rec->dropped += n - room;
+		n = room;
+	}
+	for ( x=0; x<n; ++x )
+		rec->ring[(h + x) & EDGE_REC_MASK] = edges[x];
+	__atomic_store_n(&rec->head,h+n,__ATOMIC_RELEASE);
+	return n;
+}
+
+/*********************************************************************
+ * Edges dropped so far because the writer fell behind
+ *********************************************************************/
+unsigned
+edge_rec_dropped(edge_rec_t *rec) {
+	return rec->dropped;
+}
+
+/*********************************************************************
+ * Write out what is queued and close the recording. Returns the
+ * number of edges written.
+ *********************************************************************/
+unsigned long long
+edge_rec_close(edge_rec_t *rec) {
+	unsigned long long written;
+
+	__atomic_store_n(&rec->done,1,__ATOMIC_RELEASE);
+	pthread_join(rec->tid,0);
+	if ( fclose(rec->f) && !rec->failed )
+		perror("Closing edge recording");
+	if ( rec->dropped )
+		fprintf(stderr,"Edge recording: %u edges dropped\n",rec->dropped);
+
+	written = rec->written;
+	free(rec->ring);
+	free(rec);
+	return written;
+}
+
+/*********************************************************************
+ * Open a recording to read (0 on failure, reported)
+ *********************************************************************/
+FILE *
+edge_rec_fopen(const char *path) {
+	char magic[8];
+	FILE *f = user_fopen(path,"r");
+
+	if ( !f ) {
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),path);
+		return 0;
+	}
+	if ( fread(magic,1,8,f) != 8 || memcmp(magic,EDGE_REC_MAGIC,8) ) {
+		fprintf(stderr,"%s: not an edge recording\n",path);
+		fclose(f);
+		return 0;
+	}
+	return f;
+}
+
+/*********************************************************************
+ * Read the next edge: returns 1, or 0 at the end
+ *********************************************************************/
+int
+edge_rec_read(FILE *f,gpio_edge_t *edge) {
+	return fread(edge,sizeof *edge,1,f) == 1;
+}
+
+/*********************************************************************
+ * End edge_rec.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
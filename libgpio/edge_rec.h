@@ -0,0 +1,42 @@
+/*********************************************************************
+ * edge_rec.h : Binary recording of GPIO edges (libgpio)
+ *
+ * edge_rec_put() copies edges into a preallocated ring and returns
+ * at once; a writer thread streams the ring to the file. With one
+ * producer and one consumer the ring needs no lock. When the writer
+ * falls a whole ring behind, edges are dropped (and counted) rather
+ * than stalling the caller's event loop.
+ *
+ * The file is EDGE_REC_MAGIC followed by gpio_edge_t records, in
+ * host byte order. edgeexport converts it to VCD or CSV. Recordings
+ * are opened with the real user's rights (user_file.h), since the
+ * tools that make them are setuid root.
+ *********************************************************************/
+
+#ifndef EDGE_REC_H
+#define EDGE_REC_H
+
+#include <stdio.h>
+
+#include "gpio_line.h"		/* gpio_edge_t */
+
+#define EDGE_REC_MAGIC	"GPEDGE1\n"	/* 8 bytes */
+#define EDGE_REC_SLOTS	65536		/* Ring size (a power of 2) */
+
+typedef struct edge_rec edge_rec_t;
+
+edge_rec_t *edge_rec_open(const char *path);
+unsigned edge_rec_put(edge_rec_t *rec,const gpio_edge_t *edges,unsigned n);
+unsigned edge_rec_dropped(edge_rec_t *rec);
+unsigned long long edge_rec_close(edge_rec_t *rec);
+
+FILE *edge_rec_fopen(const char *path);
+int edge_rec_read(FILE *f,gpio_edge_t *edge);
+
+#endif /* EDGE_REC_H */
+
+/*********************************************************************
+ * End edge_rec.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,107 @@
+/*********************************************************************
+ * edgeexport.c : Convert an edge recording to VCD or CSV
+ *
+ * ./edgeexport [-c] file.edg >file.vcd
+ *
+ * VCD (the default) loads into GTKWave, with a wire per GPIO that
+ * changed, starting 1 us before the first edge. -c writes CSV lines
+ * of time_ns,gpio,level instead (time from the first edge), which
+ * gnuplot and spreadsheets read directly.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "edge_rec.h"			/* Edge recordings */
+#include "vcd.h"			/* VCD writer */
+
+/*
+ * Write the recording as VCD, after a first pass to find the GPIOs
+ * and the levels they had before their first edge :
+ */
+static unsigned long long
+export_vcd(FILE *f) {
+	unsigned long long mask = 0, levels = 0, t0 = 0, t = 0, edges = 0, bit;
+	gpio_edge_t edge;
+	vcd_t vcd;
+
+	while ( edge_rec_read(f,&edge) ) {
+		if ( edge.gpio < 0 || edge.gpio >= 64 )
+			continue;
+		bit = 1ULL << edge.gpio;
+		if ( !(mask & bit) ) {
+			mask |= bit;
+			if ( !edge.level )
+				levels |= bit;	/* It was high until the edge */
+		}
+		if ( !t0 )
+			t0 = edge.ns;
+	}
+
+	fseek(f,8,SEEK_SET);
+	vcd_begin(&vcd,stdout,"edges",mask);
+	vcd_sample(&vcd,t0 > 1000 ? t0 - 1000 : 0,levels);
+
+	while ( edge_rec_read(f,&edge) ) {
+		if ( edge.gpio < 0 || edge.gpio >= 64 )
+			continue;
+		bit = 1ULL << edge.gpio;
+		levels = edge.level ? levels | bit : levels & ~bit;
+		vcd_sample(&vcd,t = edge.ns,levels);
+		++edges;
+	}
+	vcd_end(&vcd,t);
+	return edges;
+}
+
+/*
+ * Write the recording as CSV :
+ */
+static unsigned long long
+export_csv(FILE *f) {
+	unsigned long long t0 = 0, edges = 0;
+	gpio_edge_t edge;
+
+	puts("time_ns,gpio,level");
+	while ( edge_rec_read(f,&edge) ) {
+		if ( !edges++ )
+			t0 = edge.ns;
+		printf("%llu,%d,%d\n",edge.ns - t0,edge.gpio,edge.level);
+	}
+	return edges;
+}
+
+int
+main(int argc,char **argv) {
+	unsigned long long edges;
+	int optch, f_csv = 0;
+	FILE *f;
+
+	while ( (optch = getopt(argc,argv,"ch")) != EOF )
+		switch ( optch ) {
+		case 'c' :
+			f_csv = 1;
+			break;
+		default :
+usage:			fprintf(stderr,"Usage: %s [-c] file.edg >file.vcd (or .csv with -c)\n",argv[0]);
+			return 1;
+		}
+
+	if ( optind + 1 != argc )
+		goto usage;
+	if ( !(f = edge_rec_fopen(argv[optind])) )
+		return 1;
+
+	edges = f_csv ? export_csv(f) : export_vcd(f);
+	fclose(f);
+	fprintf(stderr,"%llu edges converted.\n",edges);
+	return 0;
+}
+
+/*********************************************************************
+ * End edgeexport.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
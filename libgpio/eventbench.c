@@ -0,0 +1,263 @@
+/*********************************************************************
+ * eventbench.c : Compare ways of catching GPIO edges
+ *
+ * ./eventbench [-o gpio] [-i gpio] [-n pulses] [-w ns] [-p us] [test ...]
+ *
+ * A generator thread sends pulses on the output GPIO, which must be
+ * wired to the input GPIO. Each test counts the rising edges seen on
+ * the input while the pulses are sent:
+ *
+ *	level	polling GPLEV0 for changes
+ *	events	polling GPEDS0 (gpio_event_take())
+ *	line	kernel edge events (gpio_line.h: GPIO_LINE=chip or sysfs)
+ *
+ * With the simulator (the default unless GPIO_BACKEND is set) the
+ * generator drives the input directly, and feeds the line test
+ * through the gpio_line stand-in.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "gpio_io.h"
+#include "gpio_sim.h"
+#include "gpio_time.h"
+#include "gpio_line.h"
+
+static int gpio_out = 17;		/* Pulse output */
+static int gpio_in = 27;		/* Wired to gpio_out */
+static unsigned pulses = 10000;		/* Pulses per test */
+static unsigned width_ns = 1000;	/* High time of each pulse */
+static unsigned period_us = 100;	/* Pulse period */
+static int simulated = 0;		/* Running on the sim backend */
+static volatile int sending = 0;	/* Generator is running */
+static gpio_line_t *test_line = 0;	/* Line under test */
+
+/*
+ * Drive the pulse line :
+ */
+static inline void
+drive(int level) {
+	if ( simulated ) {
+		gpio_sim_input(gpio_in,level);
+		if ( test_line )
+			gpio_line_sim_edge(test_line,level,0);
+	} else	gpio_write(gpio_out,level);
+}
+
+/*
+ * Generator thread :
+ */
+static void *
+generator(void *arg) {
+	unsigned x;
+
+	for ( x=0; x<pulses; ++x ) {
+		drive(1);
+		gpio_delay_ns(width_ns);
+		drive(0);
+		gpio_delay_ns(period_us * 1000UL - width_ns);
+	}
+	sending = 0;
+	return 0;
+}
+
+/*
+ * Start the generator and return the start time :
+ */
+static unsigned long long
+start(pthread_t *tid) {
+	drive(0);
+	sending = 1;
+	pthread_create(tid,0,generator,0);
+	return gpio_ns();
+}
+
+/*
+ * Wait for the generator and report the edges seen :
+ */
+static void
+finish(pthread_t tid,const char *what,unsigned long long t0,unsigned seen) {
+	double secs;
+
+	pthread_join(tid,0);
+	secs = (gpio_ns() - t0) / 1e9;
+	printf("  %-8s %8u sent %8u seen %8u missed %10.0f edges/sec\n",
+		what,pulses,seen,pulses > seen ? pulses - seen : 0,seen / secs);
+}
+
+/*********************************************************************
+ * Poll the level register, counting rising edges
+ *********************************************************************/
+static void
+bench_level(void) {
+	unsigned long long t0;
+	unsigned seen = 0;
+	int last = 0, v;
+	pthread_t tid;
+
+	t0 = start(&tid);
+	while ( sending ) {
+		v = gpio_read(gpio_in);
+		if ( v && !last )
+			++seen;
+		last = v;
+	}
+	finish(tid,"level",t0,seen);
+}
+
+/*********************************************************************
+ * Poll the event detect status register
+ *********************************************************************/
+static void
+bench_events(void) {
+	unsigned long long t0;
+	unsigned seen = 0, bit = GPIO_BIT(gpio_in);
+	pthread_t tid;
+
+	if ( gpio_event_config(gpio_in,GPIO_EV_RISING) )
+		return;
+
+	t0 = start(&tid);
+	while ( sending )
+		if ( gpio_event_take(bit) )
+			++seen;
+	if ( gpio_event_take(bit) )		/* The last pulse */
+		++seen;
+	finish(tid,"events",t0,seen);
+
+	gpio_event_config(gpio_in,0);
+}
+
+/*********************************************************************
+ * Wait for edges from the kernel (gpio_line.h: chip or sysfs)
+ *********************************************************************/
+static void
+bench_line(void) {
+	gpio_edge_t edges[64];
+	unsigned long long t0;
+	unsigned seen = 0;
+	pthread_t tid;
+	char what[16];
+	int n;
+
+	if ( !(test_line = gpio_line_input(gpio_in,GPIO_EV_RISING,0)) )
+		return;
+	snprintf(what,sizeof what,"%s",gpio_line_backend(test_line));
+
+	t0 = start(&tid);
+	for (;;) {
+		n = gpio_line_wait(test_line,edges,64,sending ? 100 : 0);
+		if ( n > 0 )
+			seen += n;
+		else if ( !sending )
+			break;
+	}
+	finish(tid,what,t0,seen);
+	if ( gpio_line_dropped(test_line) )
+		printf("  %-8s %8u dropped by the kernel\n",what,gpio_line_dropped(test_line));
+
+	gpio_line_close(test_line);
+	test_line = 0;
+}
+
+static struct {
+	const char	*name;		/* Test name */
+	void		(*func)(void);	/* Test routine */
+} tests[] = {
+	{ "level",	bench_level },
+	{ "events",	bench_events },
+	{ "line",	bench_line },
+	{ 0, 0 }
+};
+
+/*
+ * Main program :
+ */
+int
+main(int argc,char **argv) {
+	gpio_fsel_t tx;
+	int optch, t, rc = 0;
+
+	while ( (optch = getopt(argc,argv,"o:i:n:w:p:h")) != EOF )
+		switch ( optch ) {
+		case 'o' :
+			gpio_out = atoi(optarg);
+			break;
+		case 'i' :
+			gpio_in = atoi(optarg);
+			break;
+		case 'n' :
+			pulses = strtoul(optarg,0,10);
+			break;
+		case 'w' :
+			width_ns = strtoul(optarg,0,10);
+			break;
+		case 'p' :
+			period_us = strtoul(optarg,0,10);
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,
+				"Usage: %s [-o gpio] [-i gpio] [-n pulses] [-w ns] [-p us] [test ...]\n",argv[0]);
+			fputs("where:\n"
+				"  -o gpio\tpulse output (17)\n"
+				"  -i gpio\tinput wired to the output (27)\n"
+				"  -n pulses\tpulses per test (10000)\n"
+				"  -w ns\t\tpulse width (1000)\n"
+				"  -p us\t\tpulse period (100)\n"
+				"Tests: level events line\n",
+				stderr);
+			return 1;
+		}
+
+	if ( gpio_out < 0 || gpio_out >= GPIO_COUNT || gpio_in < 0 || gpio_in >= 32
+	  || width_ns >= period_us * 1000UL )
+		goto usage;
+
+	if ( !getenv("GPIO_BACKEND") )
+		gpio_select_backend("sim");
+	gpio_init();
+	simulated = !strcmp(gpio_get_backend()->name,"sim");
+	gpio_time_init();
+
+	gpio_fsel_begin(&tx);
+	gpio_fsel_dir(&tx,gpio_out,Output);
+	gpio_fsel_dir(&tx,gpio_in,Input);
+	if ( gpio_fsel_commit(&tx) )
+		return 1;
+
+	printf("Backend %s, %u pulses of %u ns every %u us, GPIO %d -> GPIO %d\n",
+		gpio_get_backend()->name,pulses,width_ns,period_us,gpio_out,gpio_in);
+
+	if ( optind >= argc ) {
+		for ( t=0; tests[t].name; ++t )
+			tests[t].func();
+	} else	{
+		for ( ; optind < argc; ++optind ) {
+			for ( t=0; tests[t].name; ++t )
+				if ( !strcmp(tests[t].name,argv[optind]) )
+					break;
+			if ( tests[t].name )
+				tests[t].func();
+			else	{
+				fprintf(stderr,"Unknown test '%s'\n",argv[optind]);
+				rc = 1;
+			}
+		}
+	}
+
+	gpio_config(gpio_out,Input);
+	gpio_fini();
+	return rc;
+}
+
+/*********************************************************************
+ * End eventbench.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
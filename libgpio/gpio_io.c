@@ -0,0 +1,460 @@
+/*********************************************************************
+ * gpio_io.c : Shared GPIO Access Library (libgpio)
+ *
+ * Every tool links this one copy, so the /dev/mem open and mmap(2)
+ * happen once per process no matter how many modules use GPIO.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+
+#include "gpio_io.h"
+#include "gpio_sim.h"
+
+#define MAX_MAPS	8		/* Peripheral blocks per process */
+
+volatile unsigned *ugpio = 0;		/* GPIO registers */
+
+static pthread_mutex_t gpio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static const gpio_backend_t *backend = 0;	/* 0 until chosen */
+static unsigned refs = 0;		/* gpio_init() reference count */
+
+static struct {
+	unsigned long		offset;	/* Offset from peripheral base */
+	volatile unsigned	*regs;	/* Mapped registers */
+} maps[MAX_MAPS];
+static unsigned n_maps = 0;
+
+static pthread_mutex_t fsel_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int fsel_lockfd = -1;		/* Cross-process GPFSEL lock */
+
+/*********************************************************************
+ * Return the physical peripheral base address. The Pi 1 uses
+ * 0x20000000, the Pi 2/3 0x3F000000 and the Pi 4 0xFE000000. The
+ * device tree soc/ranges property holds <child parent size>, where
+ * the parent address is 32 bits wide, or 64 bits (high word zero)
+ * on the Pi 4.
+ *********************************************************************/
+unsigned long
+gpio_peri_base(void) {
+	static unsigned long peri_base = 0;
+	unsigned char buf[12];
+	unsigned long addr;
+	FILE *f;
+
+	if ( peri_base )
+		return peri_base;
+
+	peri_base = BCM2708_PERI_BASE;		/* Original Pi 1 */
+	f = fopen("/proc/device-tree/soc/ranges","rb");
+	if ( f ) {
+		if ( fread(buf,1,sizeof buf,f) == sizeof buf ) {
+			addr = (unsigned long)buf[4] << 24 | buf[5] << 16 | buf[6] << 8 | buf[7];
+			if ( !addr )
+				addr = (unsigned long)buf[8] << 24 | buf[9] << 16 | buf[10] << 8 | buf[11];
+			if ( addr )
+				peri_base = addr;
+		}
+		fclose(f);
+	}
+	return peri_base;
+}
+
+/*********************************************************************
+ * /dev/mem backend : Needs root access
+ *********************************************************************/
+static volatile unsigned *
+devmem_map(unsigned long offset) {
+	int fd;
+	char *map;
+
+	fd = open("/dev/mem",O_RDWR|O_SYNC);  /* Needs root access */
+	if ( fd < 0 ) {
+		perror("Opening /dev/mem");
+		return 0;
+	}
+
+	map = (char *) mmap(
+		NULL,             /* Any address */
+		BLOCK_SIZE,       /* # of bytes */
+		PROT_READ|PROT_WRITE,
+		MAP_SHARED,       /* Shared */
+		fd,               /* /dev/mem */
+		gpio_peri_base() + offset
+	);
+
+	if ( (long)map == -1L ) {
+		perror("mmap(/dev/mem)");
+		close(fd);
+		return 0;
+	}
+
+	close(fd);
+	return (volatile unsigned *)map;
+}
+
+static void
+devmem_unmap(volatile unsigned *regs) {
+	munmap((void *)regs,BLOCK_SIZE);
+}
+
+const gpio_backend_t gpio_backend_devmem = {
+	"mem", devmem_map, devmem_unmap
+};
+
+/*********************************************************************
+ * /dev/gpiomem backend : No root needed (gpio group), but only
+ * the GPIO block itself is available.
+ *********************************************************************/
+static volatile unsigned *
+gpiomem_map(unsigned long offset) {
+	int fd;
+	char *map;
+
+	if ( offset != GPIO_OFFSET ) {
+		fprintf(stderr,"/dev/gpiomem: cannot map peripheral offset 0x%lX\n",offset);
+		return 0;
+	}
+
+	fd = open("/dev/gpiomem",O_RDWR|O_SYNC);
+	if ( fd < 0 ) {
+		perror("Opening /dev/gpiomem");
+		return 0;
+	}
+
+	map = (char *) mmap(NULL,BLOCK_SIZE,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+	if ( (long)map == -1L ) {
+		perror("mmap(/dev/gpiomem)");
+		close(fd);
+		return 0;
+	}
+
+	close(fd);
+	return (volatile unsigned *)map;
+}
+
+const gpio_backend_t gpio_backend_gpiomem = {
+	"gpiomem", gpiomem_map, devmem_unmap
+};
+
+/*********************************************************************
+ * Select the backend used for mappings. This must be done before
+ * the first gpio_init() call in the process.
+ *********************************************************************/
+void
+gpio_set_backend(const gpio_backend_t *new_backend) {
+	pthread_mutex_lock(&gpio_mutex);
+	if ( refs ) {
+		fprintf(stderr,"gpio_set_backend(%s): GPIO already mapped by %s\n",
+			new_backend->name,backend->name);
+		pthread_mutex_unlock(&gpio_mutex);
+		return;
+	}
+	backend = new_backend;
+	pthread_mutex_unlock(&gpio_mutex);
+}
+
+/*********************************************************************
+ * Select a backend by name. Returns 0 if successful, else -1.
+ *********************************************************************/
+int
+gpio_select_backend(const char *name) {
+	static const gpio_backend_t *backends[] = {
+		&gpio_backend_devmem, &gpio_backend_gpiomem, &gpio_backend_sim, 0
+	};
+	unsigned x;
+
+	for ( x=0; backends[x]; ++x )
+		if ( !strcmp(backends[x]->name,name) ) {
+			gpio_set_backend(backends[x]);
+			return 0;
+		}
+	fprintf(stderr,"Unknown GPIO backend '%s' (use mem, gpiomem or sim)\n",name);
+	return -1;
+}
+
+const gpio_backend_t *
+gpio_get_backend(void) {
+	return backend ? backend : &gpio_backend_devmem;
+}
+
+/*
+ * Internal : Locate or create the mapping for offset (mutex held)
+ */
+static volatile unsigned *
+map_locked(unsigned long offset) {
+	volatile unsigned *regs;
+	unsigned x;
+
+	for ( x=0; x<n_maps; ++x )
+		if ( maps[x].offset == offset )
+			return maps[x].regs;
+
+	if ( n_maps >= MAX_MAPS ) {
+		fprintf(stderr,"gpio_map_peri(0x%lX): too many mappings\n",offset);
+		return 0;
+	}
+
+	if ( !(regs = backend->map(offset)) )
+		return 0;
+
+	maps[n_maps].offset = offset;
+	maps[n_maps].regs = regs;
+	++n_maps;
+	return regs;
+}
+
+/*********************************************************************
+ * Perform initialization to access GPIO registers:
+ * Sets up pointer ugpio. Only the first caller maps the registers.
+ *********************************************************************/
+void
+gpio_init(void) {
+	const char *name;
+
+	if ( !backend && (name = getenv("GPIO_BACKEND")) != 0 )
+		if ( gpio_select_backend(name) )
+			exit(1);
+
+	pthread_mutex_lock(&gpio_mutex);
+	if ( !backend )
+		backend = &gpio_backend_devmem;
+	if ( !refs ) {
+		ugpio = map_locked(GPIO_OFFSET);
+		if ( !ugpio )
+			exit(1);
+	}
+	++refs;
+	pthread_mutex_unlock(&gpio_mutex);
+}
+
+/*********************************************************************
+ * Release a reference. The last release unmaps all peripheral
+ * blocks, including those obtained through gpio_map_peri().
+ *********************************************************************/
+void
+gpio_fini(void) {
+	unsigned x;
+
+	pthread_mutex_lock(&gpio_mutex);
+	if ( refs && !--refs ) {
+		for ( x=0; x<n_maps; ++x )
+			backend->unmap(maps[x].regs);
+		n_maps = 0;
+		ugpio = 0;
+	}
+	pthread_mutex_unlock(&gpio_mutex);
+}
+
+/*********************************************************************
+ * Map another peripheral block (PWM, clock manager etc.) through
+ * the current backend. The caller must hold a gpio_init() reference.
+ * Returns 0 if the block cannot be mapped.
+ *********************************************************************/
+volatile unsigned *
+gpio_map_peri(unsigned long offset) {
+	volatile unsigned *regs;
+
+	pthread_mutex_lock(&gpio_mutex);
+	regs = map_locked(offset);
+	pthread_mutex_unlock(&gpio_mutex);
+	return regs;
+}
+
+/*
+ * Internal : Register access for library routines. Accesses are
+ * logged when running on the simulated backend.
+ */
+static unsigned
+reg_rd(unsigned reg) {
+	if ( backend == &gpio_backend_sim )
+		return gpio_sim_rd(reg);
+	return ugpio[reg];
+}
+
+static void
+reg_wr(unsigned reg,unsigned value) {
+	if ( backend == &gpio_backend_sim )
+		gpio_sim_wr(reg,value);
+	else	ugpio[reg] = value;
+}
+
+/*********************************************************************
+ * Start a new set of function select changes
+ *********************************************************************/
+void
+gpio_fsel_begin(gpio_fsel_t *tx) {
+	unsigned x;
+
+	for ( x=0; x<6; ++x )
+		tx->mask[x] = tx->value[x] = 0;
+}
+
+/*********************************************************************
+ * Stage function select code fsel (GPIO_FSEL_*) for gpio 0-53.
+ * A later stage of the same gpio replaces the earlier one.
+ *********************************************************************/
+void
+gpio_fsel_stage(gpio_fsel_t *tx,int gpio,unsigned fsel) {
+	unsigned reg = gpio / 10, shift = (gpio % 10) * 3;
+
+	if ( gpio < 0 || gpio > 53 ) {
+		fprintf(stderr,"gpio_fsel_stage(%d): no such GPIO\n",gpio);
+		return;
+	}
+
+	tx->mask[reg] |= 7 << shift;
+	tx->value[reg] = (tx->value[reg] & ~(7 << shift)) | (fsel & 7) << shift;
+}
+
+/*
+ * Internal : Open the lock file shared by all libgpio processes
+ */
+static int
+fsel_lock_open(void) {
+	static const char *paths[] = {
+		"/run/lock/libgpio.lock", "/tmp/libgpio.lock", 0
+	};
+	unsigned x;
+
+	if ( fsel_lockfd >= 0 )
+		return fsel_lockfd;
+
+	for ( x=0; paths[x]; ++x ) {
+		fsel_lockfd = open(paths[x],O_RDONLY|O_CREAT|O_CLOEXEC,0644);
+		if ( fsel_lockfd >= 0 )
+			return fsel_lockfd;
+	}
+	perror("Opening libgpio.lock");
+	return -1;
+}
+
+/*
+ * Internal : Take the thread and cross-process register lock, for
+ * read-modify-write of shared registers. Returns the lock fd or -1.
+ */
+static int
+regs_lock(void) {
+	int fd, rc;
+
+	pthread_mutex_lock(&fsel_mutex);	/* Threads in this process */
+	if ( (fd = fsel_lock_open()) < 0 ) {
+		pthread_mutex_unlock(&fsel_mutex);
+		return -1;
+	}
+
+	do	{
+		rc = flock(fd,LOCK_EX);		/* Other processes */
+	} while ( rc < 0 && errno == EINTR );
+	if ( rc < 0 ) {
+		perror("flock(libgpio.lock)");
+		pthread_mutex_unlock(&fsel_mutex);
+		return -1;
+	}
+	return fd;
+}
+
+static void
+regs_unlock(int fd) {
+	flock(fd,LOCK_UN);
+	pthread_mutex_unlock(&fsel_mutex);
+}
+
+/*********************************************************************
+ * Apply the staged changes: each affected GPFSELn register is read
+ * once and written once, under the cross-process lock. Returns 0 if
+ * successful, or -1 if the lock could not be taken (nothing is
+ * changed in that case).
+ *********************************************************************/
+int
+gpio_fsel_commit(gpio_fsel_t *tx) {
+	unsigned reg;
+	int fd;
+
+	if ( (fd = regs_lock()) < 0 )
+		return -1;
+
+	for ( reg=0; reg<6; ++reg )
+		if ( tx->mask[reg] )
+			reg_wr(GPFSEL0+reg,(reg_rd(GPFSEL0+reg) & ~tx->mask[reg]) | tx->value[reg]);
+
+	regs_unlock(fd);
+	return 0;
+}
+
+/*********************************************************************
+ * Enable the GPIO_EV_* edge detectors for gpio and disable the
+ * others, under the register lock. Any stale GPEDSn bit for the pin
+ * is cleared. Returns 0, or -1 for a bad gpio or a lock failure.
+ *********************************************************************/
+int
+gpio_event_config(int gpio,unsigned events) {
+	static const struct {
+		unsigned	event;		/* GPIO_EV_* */
+		unsigned	reg;		/* Enable register, bank 0 */
+	} enables[] = {
+		{ GPIO_EV_RISING,	GPREN0 },
+		{ GPIO_EV_FALLING,	GPFEN0 },
+		{ GPIO_EV_ARISING,	GPAREN0 },
+		{ GPIO_EV_AFALLING,	GPAFEN0 },
+	};
+	unsigned bank = GPIO_BANK(gpio), bit = GPIO_BIT(gpio), x, reg, v;
+	int fd;
+
+	if ( gpio < 0 || gpio >= GPIO_COUNT ) {
+		fprintf(stderr,"gpio_event_config(%d): no such GPIO\n",gpio);
+		return -1;
+	}
+	if ( (fd = regs_lock()) < 0 )
+		return -1;
+
+	for ( x=0; x<sizeof enables/sizeof enables[0]; ++x ) {
+		reg = enables[x].reg + bank;
+		v = reg_rd(reg);
+		if ( events & enables[x].event )
+			reg_wr(reg,v | bit);
+		else	reg_wr(reg,v & ~bit);
+	}
+	reg_wr(GPEDS0+bank,bit);		/* Discard a stale event */
+
+	regs_unlock(fd);
+	return 0;
+}
+
+/*********************************************************************
+ * Return the latched events among mask, clearing just those. GPEDSn
+ * is write 1 to clear, so events for other pins are not disturbed.
+ *********************************************************************/
+unsigned
+gpio_event_take(unsigned mask) {
+	unsigned ev = reg_rd(GPEDS0) & mask;
+
+	if ( ev )
+		reg_wr(GPEDS0,ev);
+	return ev;
+}
+
+unsigned long long
+gpio_event_take64(unsigned long long mask) {
+	unsigned long long ev = gpio_event_take(mask);
+	unsigned hi;
+
+	if ( mask >> 32 && (hi = reg_rd(GPEDS1) & (unsigned)(mask >> 32)) != 0 ) {
+		reg_wr(GPEDS1,hi);
+		ev |= (unsigned long long)hi << 32;
+	}
+	return ev;
+}
+
+/*********************************************************************
+ * End gpio_io.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
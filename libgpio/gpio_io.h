@@ -0,0 +1,324 @@
+/*********************************************************************
+ * gpio_io.h : Shared GPIO Access Library (libgpio)
+ *
+ * One register mapping is shared by every user in the process.
+ * gpio_init() may be called any number of times; each call must be
+ * balanced by gpio_fini(), and the mapping is released with the last.
+ *
+ * The backend is chosen by gpio_select_backend() or, failing that,
+ * by the environment variable GPIO_BACKEND (mem, gpiomem or sim).
+ * The default is /dev/mem.
+ *********************************************************************/
+
+#ifndef GPIO_IO_H
+#define GPIO_IO_H
+
+#define BCM2708_PERI_BASE       0x20000000
+#define GPIO_OFFSET             0x200000	/* GPIO block from PERI_BASE */
+#define GPIO_BASE               (BCM2708_PERI_BASE + GPIO_OFFSET)
+#define BLOCK_SIZE (4*1024)
+
+/*
+ * GPIO register word indexes :
+ */
+#define GPFSEL0     0           /* Function select (10 GPIOs each) */
+#define GPSET0      7           /* Output set, GPIOs 0-31 */
+#define GPSET1      8           /* Output set, GPIOs 32-53 */
+#define GPCLR0      10          /* Output clear, GPIOs 0-31 */
+#define GPCLR1      11          /* Output clear, GPIOs 32-53 */
+#define GPLEV0      13          /* Pin level, GPIOs 0-31 */
+#define GPLEV1      14          /* Pin level, GPIOs 32-53 */
+#define GPEDS0      16          /* Event detect status (write 1 to clear) */
+#define GPEDS1      17
+#define GPREN0      19          /* Rising edge detect enable */
+#define GPFEN0      22          /* Falling edge detect enable */
+#define GPAREN0     31          /* Async rising edge detect enable */
+#define GPAFEN0     34          /* Async falling edge detect enable */
+
+#define GPIO_COUNT  54          /* GPIOs 0-53, in two 32 bit banks */
+#define GPIO_BANK(g)    ((g) >> 5)          /* Register offset from ..0 */
+#define GPIO_BIT(g)     (1u << ((g) & 31))  /* Bit within the bank */
+
+/*
+ * Every register access made by the inline routines below goes
+ * through GPIO_REG_RD()/GPIO_REG_WR(). Compiling a tool with
+ * -DGPIO_SIM_TRACE routes them through the simulator (gpio_sim.h),
+ * which timestamps each access and models GPSET/GPCLR on GPLEV.
+ */
+#ifndef GPIO_SIM_TRACE
+#define GPIO_REG_RD(r)      (ugpio[(r)])
+#define GPIO_REG_WR(r,v)    (ugpio[(r)] = (v))
+#else
+#define GPIO_REG_RD(r)      gpio_sim_rd((r))
+#define GPIO_REG_WR(r,v)    gpio_sim_wr((r),(v))
+unsigned gpio_sim_rd(unsigned reg);
+void gpio_sim_wr(unsigned reg,unsigned value);
+#endif
+
+/*
+ * Other peripheral blocks (PWM, clocks, DMA) are accessed with
+ * PERI_RD()/PERI_WR(). A program compiled with -DPERI_TRACE supplies
+ * peri_trace_rd()/peri_trace_wr(), which see the block's variable
+ * name, for checking register sequences (pwm/pwmcheck.c).
+ */
+#ifndef PERI_TRACE
+#define PERI_RD(blk,r)      ((blk)[(r)])
+#define PERI_WR(blk,r,v)    ((blk)[(r)] = (v))
+#else
+#define PERI_RD(blk,r)      peri_trace_rd(#blk,(blk),(r))
+#define PERI_WR(blk,r,v)    peri_trace_wr(#blk,(blk),(r),(v))
+unsigned peri_trace_rd(const char *blk,volatile unsigned *regs,unsigned reg);
+void peri_trace_wr(const char *blk,volatile unsigned *regs,unsigned reg,unsigned value);
+#endif
+
+/* GPIO setup macros. Always use INP_GPIO(x) before using OUT_GPIO(x)
+   or SET_GPIO_ALT(x,y) */
+#define INP_GPIO(g) \
+    GPIO_REG_WR((g)/10,GPIO_REG_RD((g)/10) & ~(7<<(((g)%10)*3)))
+#define OUT_GPIO(g) \
+    GPIO_REG_WR((g)/10,GPIO_REG_RD((g)/10) | (1<<(((g)%10)*3)))
+#define SET_GPIO_ALT(g,a) \
+    GPIO_REG_WR((g)/10,GPIO_REG_RD((g)/10) | \
+        (((a)<=3?(a)+4:(a)==4?3:2)<<(((g)%10)*3)))
+
+/* Function select codes, as found in the GPFSELn 3 bit fields */
+#define GPIO_FSEL_INPUT     0
+#define GPIO_FSEL_OUTPUT    1
+#define GPIO_FSEL_ALT(a)    ((a)<=3?(a)+4:(a)==4?3:2)
+
+/* Direct register lvalues (not seen by GPIO_SIM_TRACE) */
+#define GPIO_SET *(ugpio+GPSET0)    /* sets   bits */
+#define GPIO_CLR *(ugpio+GPCLR0)    /* clears bits */
+#define GPIO_GET *(ugpio+GPLEV0)    /* gets   all GPIO input levels */
+
+typedef enum {
+    Input = 0,                  /* GPIO is an Input */
+    Output                      /* GPIO is an Output */
+} direction_t;
+
+/*
+ * A backend supplies the peripheral register mappings. The offset
+ * is relative to the peripheral base (GPIO_OFFSET for GPIO).
+ * map() returns 0 (after reporting why) when it cannot comply.
+ */
+typedef struct {
+    const char *name;                           /* Backend name */
+    volatile unsigned *(*map)(unsigned long offset);
+    void (*unmap)(volatile unsigned *regs);
+} gpio_backend_t;
+
+extern const gpio_backend_t gpio_backend_devmem;	/* /dev/mem */
+extern const gpio_backend_t gpio_backend_gpiomem;	/* /dev/gpiomem */
+extern const gpio_backend_t gpio_backend_sim;		/* Simulated */
+
+extern volatile unsigned *ugpio;	/* GPIO registers (after gpio_init) */
+
+void gpio_set_backend(const gpio_backend_t *backend);
+int gpio_select_backend(const char *name);	/* "mem", "gpiomem", "sim" */
+const gpio_backend_t *gpio_get_backend(void);
+unsigned long gpio_peri_base(void);		/* Physical peripheral base */
+
+void gpio_init(void);			/* Map GPIO (reference counted) */
+void gpio_fini(void);			/* Release one reference */
+volatile unsigned *gpio_map_peri(unsigned long offset);
+
+/*
+ * Staged function select changes. Stage any number of pins, then
+ * gpio_fsel_commit() updates each affected GPFSELn register with a
+ * single read and a single write, while holding a lock that is
+ * shared with other threads and other libgpio processes.
+ */
+typedef struct {
+    unsigned mask[6];           /* Fields being changed, per GPFSELn */
+    unsigned value[6];          /* New field values, per GPFSELn */
+} gpio_fsel_t;
+
+void gpio_fsel_begin(gpio_fsel_t *tx);
+void gpio_fsel_stage(gpio_fsel_t *tx,int gpio,unsigned fsel);
+int gpio_fsel_commit(gpio_fsel_t *tx);	/* Returns 0 or -1 */
+
+#define gpio_fsel_dir(tx,gpio,output) \
+    gpio_fsel_stage((tx),(gpio),(output) ? GPIO_FSEL_OUTPUT : GPIO_FSEL_INPUT)
+#define gpio_fsel_alt(tx,gpio,alt) \
+    gpio_fsel_stage((tx),(gpio),GPIO_FSEL_ALT(alt))
+
+/*
+ * Hardware event detection. Enabled edges latch a bit in GPEDSn that
+ * stays set until cleared, so a polling loop cannot miss a pulse
+ * that comes and goes between two reads of GPLEVn. The synchronous
+ * detectors sample with the system clock; the asynchronous ones
+ * catch even shorter pulses. gpio_event_take() reads GPEDS0 and
+ * clears the bits it returns, for any number of pins in one pass.
+ */
+#define GPIO_EV_RISING      0x01        /* GPRENn */
+#define GPIO_EV_FALLING     0x02        /* GPFENn */
+#define GPIO_EV_ARISING     0x04        /* GPARENn */
+#define GPIO_EV_AFALLING    0x08        /* GPAFENn */
+#define GPIO_EV_BOTH        (GPIO_EV_RISING|GPIO_EV_FALLING)
+
+int gpio_event_config(int gpio,unsigned events); /* GPIO_EV_*, 0 disables */
+unsigned gpio_event_take(unsigned mask);	/* GPIOs 0-31 */
+unsigned long long gpio_event_take64(unsigned long long mask);
+
+/*********************************************************************
+ * Configure GPIO as Input or Output (one GPFSELn read and write,
+ * but unlocked: use gpio_fsel_commit() when others may be changing
+ * pins that share the register)
+ *********************************************************************/
+static inline void
+gpio_config(int gpio,direction_t output) {
+    unsigned shift = (gpio % 10) * 3;
+
+    GPIO_REG_WR(gpio/10,(GPIO_REG_RD(gpio/10) & ~(7 << shift))
+        | (output ? GPIO_FSEL_OUTPUT : GPIO_FSEL_INPUT) << shift);
+}
+
+/*********************************************************************
+ * Write a bit to the GPIO pin (0-53)
+ *********************************************************************/
+static inline void
+gpio_write(int gpio,int bit) {
+    unsigned sel = GPIO_BIT(gpio);
+
+    if ( bit ) {
+        GPIO_REG_WR(GPSET0+GPIO_BANK(gpio),sel);
+    } else  {
+        GPIO_REG_WR(GPCLR0+GPIO_BANK(gpio),sel);
+    }
+}
+
+/*********************************************************************
+ * Read a bit from a GPIO pin (0-53)
+ *********************************************************************/
+static inline int
+gpio_read(int gpio) {
+    unsigned sel = GPIO_BIT(gpio);
+
+    return GPIO_REG_RD(GPLEV0+GPIO_BANK(gpio)) & sel ? 1 : 0;
+}
+
+/*********************************************************************
+ * Multi-pin access for GPIOs 0-31. Bit n of a mask selects GPIO n.
+ *
+ * gpio_write_mask() drives every GPIO in mask to the matching bit
+ * of value using at most two register stores: one GPSET0 store for
+ * the bits going high, then one GPCLR0 store for the bits going low.
+ * All pins in the same store change together.
+ *********************************************************************/
+static inline void
+gpio_set_mask(unsigned mask) {
+    GPIO_REG_WR(GPSET0,mask);
+}
+
+static inline void
+gpio_clr_mask(unsigned mask) {
+    GPIO_REG_WR(GPCLR0,mask);
+}
+
+static inline void
+gpio_write_mask(unsigned value,unsigned mask) {
+    unsigned set = value & mask;
+    unsigned clr = ~value & mask;
+
+    if ( set )
+        GPIO_REG_WR(GPSET0,set);
+    if ( clr )
+        GPIO_REG_WR(GPCLR0,clr);
+}
+
+/*********************************************************************
+ * Snapshot reads : one GPLEV0 load for all of GPIOs 0-31
+ *********************************************************************/
+static inline unsigned
+gpio_read_all(void) {
+    return GPIO_REG_RD(GPLEV0);
+}
+
+static inline unsigned
+gpio_read_mask(unsigned mask) {
+    return GPIO_REG_RD(GPLEV0) & mask;
+}
+
+/*********************************************************************
+ * All 54 GPIOs as one 64 bit mask: bit n selects GPIO n. Each bank
+ * is one store or load, so the two banks are not simultaneous.
+ * gpio_read_all64() returns every level in two loads.
+ *********************************************************************/
+static inline void
+gpio_set_mask64(unsigned long long mask) {
+    if ( (unsigned)mask )
+        GPIO_REG_WR(GPSET0,(unsigned)mask);
+    if ( mask >> 32 )
+        GPIO_REG_WR(GPSET1,(unsigned)(mask >> 32));
+}
+
+static inline void
+gpio_clr_mask64(unsigned long long mask) {
+    if ( (unsigned)mask )
+        GPIO_REG_WR(GPCLR0,(unsigned)mask);
+    if ( mask >> 32 )
+        GPIO_REG_WR(GPCLR1,(unsigned)(mask >> 32));
+}
+
+static inline void
+gpio_write_mask64(unsigned long long value,unsigned long long mask) {
+    gpio_set_mask64(value & mask);
+    gpio_clr_mask64(~value & mask);
+}
+
+static inline unsigned long long
+gpio_read_all64(void) {
+    unsigned lo = GPIO_REG_RD(GPLEV0);
+
+    return (unsigned long long)GPIO_REG_RD(GPLEV1) << 32 | lo;
+}
+
+/*********************************************************************
+ * Fixed pin specialization. GPIO_PIN(name,gpio) declares the enum
+ * constant name (= gpio) and inline routines for that one pin:
+ *
+ *	name_config(dir)	name_set()	name_clr()
+ *	name_write(bit)		name_read()
+ *
+ * The register index, shift and mask are all constant expressions,
+ * so name_set() and name_clr() compile to a single store, even at -O0.
+ * Any of GPIOs 0-53 may be used.
+ *
+ *	GPIO_PIN(lcd_sclk,22);
+ *	...
+ *	lcd_sclk_set();
+ *********************************************************************/
+#define GPIO_PIN(name,g) \
+static inline void \
+name##_config(direction_t output) { \
+    GPIO_REG_WR((g)/10,(GPIO_REG_RD((g)/10) & ~(7 << ((g)%10)*3)) \
+        | (output ? GPIO_FSEL_OUTPUT : GPIO_FSEL_INPUT) << ((g)%10)*3); \
+} \
+static inline void \
+name##_set(void) { \
+    GPIO_REG_WR(GPSET0+GPIO_BANK(g),GPIO_BIT(g)); \
+} \
+static inline void \
+name##_clr(void) { \
+    GPIO_REG_WR(GPCLR0+GPIO_BANK(g),GPIO_BIT(g)); \
+} \
+static inline void \
+name##_write(int bit) { \
+    if ( bit ) \
+        GPIO_REG_WR(GPSET0+GPIO_BANK(g),GPIO_BIT(g)); \
+    else \
+        GPIO_REG_WR(GPCLR0+GPIO_BANK(g),GPIO_BIT(g)); \
+} \
+static inline int \
+name##_read(void) { \
+    return GPIO_REG_RD(GPLEV0+GPIO_BANK(g)) >> ((g) & 31) & 1; \
+} \
+enum { name = (g) }
+
+#endif /* GPIO_IO_H */
+
+/*********************************************************************
+ * End gpio_io.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
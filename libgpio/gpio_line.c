@@ -0,0 +1,554 @@
+/*********************************************************************
+ * gpio_line.c : Kernel GPIO line access with edge events (libgpio)
+ *********************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "gpio_line.h"
+
+#define N_BATCH		64		/* Kernel events per read() */
+
+typedef enum {
+	line_chip = 0,			/* /dev/gpiochipN */
+	line_sysfs,			/* /sys/class/gpio */
+	line_sim			/* Local stand-in */
+} line_kind_t;
+
+static const char *kind_names[] = { "chip", "sysfs", "sim" };
+
+struct gpio_line {
+	line_kind_t	kind;		/* Backend */
+	int		gpio;		/* GPIO number (chip offset) */
+	int		fd;		/* Line, value or pipe fd */
+	int		wfd;		/* sim: pipe write end */
+	unsigned	events;		/* GPIO_EV_RISING/FALLING */
+	unsigned long long debounce_ns;	/* sysfs, sim: software debounce */
+	unsigned	debounce_us;	/* As requested */
+	unsigned long long last_ns;	/* Time of last edge reported */
+	int		level;		/* Last level reported or set */
+	unsigned	seqno;		/* Last line_seqno seen */
+	unsigned	dropped;	/* Edges lost */
+	int		exported;	/* sysfs: we exported the GPIO */
+	int		sim_level;	/* sim: current level */
+	unsigned	sim_seqno;	/* sim: last line_seqno queued */
+};
+
+/*
+ * Internal : CLOCK_MONOTONIC in nanoseconds
+ */
+static unsigned long long
+mono_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Internal : Choose the backend for a new line
+ */
+static line_kind_t
+line_kind(void) {
+	const char *name = getenv("GPIO_LINE");
+	const char *be = getenv("GPIO_BACKEND");
+	const char *chip = getenv("GPIO_CHIP");
+	unsigned x;
+
+	if ( name ) {
+		for ( x=0; x<sizeof kind_names/sizeof kind_names[0]; ++x )
+			if ( !strcmp(name,kind_names[x]) )
+				return (line_kind_t)x;
+		fprintf(stderr,"GPIO_LINE=%s: unknown (chip, sysfs or sim)\n",name);
+	}
+	if ( (be && !strcmp(be,"sim")) || gpio_get_backend() == &gpio_backend_sim )
+		return line_sim;
+	if ( !access(chip ? chip : "/dev/gpiochip0",F_OK) )
+		return line_chip;
+	return line_sysfs;
+}
+
+/*
+ * Internal : Allocate a line
+ */
+static gpio_line_t *
+line_alloc(int gpio,unsigned events,unsigned debounce_us) {
+	gpio_line_t *line;
+
+	if ( gpio < 0 || gpio >= GPIO_COUNT ) {
+		fprintf(stderr,"gpio_line(%d): no such GPIO\n",gpio);
+		return 0;
+	}
+	if ( !(line = calloc(1,sizeof *line)) )
+		return 0;
+	line->kind = line_kind();
+	line->gpio = gpio;
+	line->fd = line->wfd = -1;
+	line->events = events;
+	line->debounce_ns = debounce_us * 1000ULL;
+	line->debounce_us = debounce_us;
+	return line;
+}
+
+/*********************************************************************
+ * chip backend
+ *********************************************************************/
+
+/*
+ * Internal : Line configuration for an output at level, or an input
+ * reporting line->events
+ */
+static void
+chip_config(gpio_line_t *line,int output,int level,unsigned debounce_us,struct gpio_v2_line_config *config) {
+	memset(config,0,sizeof *config);
+	if ( output ) {
+		config->flags = GPIO_V2_LINE_FLAG_OUTPUT;
+		config->num_attrs = 1;
+		config->attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		config->attrs[0].attr.values = level ? 1 : 0;
+		config->attrs[0].mask = 1;
+	} else	{
+		config->flags = GPIO_V2_LINE_FLAG_INPUT;
+		if ( line->events & GPIO_EV_RISING )
+			config->flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+		if ( line->events & GPIO_EV_FALLING )
+			config->flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+		if ( debounce_us ) {
+			config->num_attrs = 1;
+			config->attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+			config->attrs[0].attr.debounce_period_us = debounce_us;
+			config->attrs[0].mask = 1;
+		}
+	}
+}
+
+/*
+ * Internal : Request the line from /dev/gpiochipN
+ */
+static int
+chip_request(gpio_line_t *line,int output,int level,unsigned debounce_us) {
+	const char *chip = getenv("GPIO_CHIP");
+	struct gpio_v2_line_request req;
+	int fd, rc;
+
+	if ( !chip )
+		chip = "/dev/gpiochip0";
+	if ( (fd = open(chip,O_RDWR|O_CLOEXEC)) < 0 ) {
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),chip);
+		return -1;
+	}
+
+	memset(&req,0,sizeof req);
+	req.offsets[0] = line->gpio;
+	req.num_lines = 1;
+	strncpy(req.consumer,"libgpio",sizeof req.consumer-1);
+	chip_config(line,output,level,debounce_us,&req.config);
+	if ( !output )
+		req.event_buffer_size = 1024;	/* IR bursts etc. */
+
+	rc = ioctl(fd,GPIO_V2_GET_LINE_IOCTL,&req);
+	close(fd);
+	if ( rc < 0 ) {
+		fprintf(stderr,"%s: requesting line %d of %s\n",strerror(errno),line->gpio,chip);
+		return -1;
+	}
+	line->fd = req.fd;
+	line->debounce_ns = 0;			/* The kernel debounces */
+	return 0;
+}
+
+/*
+ * Internal : Convert kernel event records into edges. Gaps in
+ * line_seqno are edges the kernel had to discard.
+ */
+static int
+chip_edges(gpio_line_t *line,const struct gpio_v2_line_event *kev,int n,gpio_edge_t *edges) {
+	int x, e = 0;
+
+	for ( x=0; x<n; ++x ) {
+		if ( line->seqno && kev[x].line_seqno > line->seqno + 1 )
+			line->dropped += kev[x].line_seqno - line->seqno - 1;
+		line->seqno = kev[x].line_seqno;
+
+		edges[e].ns = kev[x].timestamp_ns;
+		edges[e].gpio = line->gpio;
+		edges[e].level = kev[x].id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+
+		/* Software debounce (sim only: the kernel does it for chip) */
+		if ( line->debounce_ns && line->last_ns
+		  && edges[e].ns - line->last_ns < line->debounce_ns )
+			continue;
+		line->last_ns = edges[e].ns;
+		line->level = edges[e].level;
+		++e;
+	}
+	return e;
+}
+
+/*
+ * Internal : Read up to max events in one read() (chip and sim)
+ */
+static int
+chip_read(gpio_line_t *line,gpio_edge_t *edges,unsigned max) {
+	struct gpio_v2_line_event kev[N_BATCH];
+	int n;
+
+	if ( max > N_BATCH )
+		max = N_BATCH;
+	n = read(line->fd,kev,max * sizeof kev[0]);
+	if ( n < 0 )
+		return -1;
+	return chip_edges(line,kev,n / sizeof kev[0],edges);
+}
+
+/*********************************************************************
+ * sysfs backend
+ *********************************************************************/
+
+/*
+ * Internal : Write text to /sys/class/gpio/<file>, where file may
+ * contain %d for the GPIO number. Freshly exported files may not be
+ * writable until udev has adjusted them.
+ */
+static int
+sysfs_put(int gpio,const char *file,const char *text) {
+	char name[32], path[64];
+	int fd, tries, rc;
+
+	snprintf(name,sizeof name,file,gpio);
+	snprintf(path,sizeof path,"/sys/class/gpio/%s",name);
+
+	for ( tries=0; (fd = open(path,O_WRONLY)) < 0 && errno == EACCES && tries < 20; ++tries )
+		usleep(50000);
+	if ( fd < 0 ) {
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),path);
+		return -1;
+	}
+	rc = write(fd,text,strlen(text));
+	close(fd);
+	return rc < 0 ? -1 : 0;
+}
+
+/*
+ * Internal : Export and configure the GPIO, opening its value file
+ */
+static int
+sysfs_open(gpio_line_t *line,int output,int level) {
+	static const char *edges[] = { "none", "rising", "falling", "both" };
+	char buf[64];
+
+	snprintf(buf,sizeof buf,"/sys/class/gpio/gpio%d/value",line->gpio);
+	if ( access(buf,F_OK) ) {
+		snprintf(buf,sizeof buf,"%d\n",line->gpio);
+		if ( sysfs_put(line->gpio,"export",buf) )
+			return -1;
+		line->exported = 1;
+	}
+
+	if ( sysfs_put(line->gpio,"gpio%d/direction",output ? (level ? "high\n" : "low\n") : "in\n") )
+		return -1;
+	if ( !output && sysfs_put(line->gpio,"gpio%d/edge",edges[line->events & GPIO_EV_BOTH]) )
+		return -1;
+
+	snprintf(buf,sizeof buf,"/sys/class/gpio/gpio%d/value",line->gpio);
+	if ( (line->fd = open(buf,O_RDWR|O_CLOEXEC)) < 0 ) {
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),buf);
+		return -1;
+	}
+	line->level = gpio_line_get(line);	/* Also clears the first POLLPRI */
+	return 0;
+}
+
+/*********************************************************************
+ * Request gpio as an input reporting the GPIO_EV_RISING and/or
+ * GPIO_EV_FALLING edges. Edges closer together than debounce_us
+ * (0 for none) are suppressed. Returns 0 on failure.
+ *********************************************************************/
+gpio_line_t *
+gpio_line_input(int gpio,unsigned events,unsigned debounce_us) {
+	gpio_line_t *line = line_alloc(gpio,events,debounce_us);
+	int pipefd[2], rc = -1;
+
+	if ( !line )
+		return 0;
+
+	switch ( line->kind ) {
+	case line_chip :
+		rc = chip_request(line,0,0,debounce_us);
+		break;
+	case line_sysfs :
+		rc = sysfs_open(line,0,0);
+		break;
+	case line_sim :
+		if ( !(rc = pipe2(pipefd,O_CLOEXEC)) ) {
+			line->fd = pipefd[0];
+			line->wfd = pipefd[1];
+			fcntl(line->wfd,F_SETFL,O_NONBLOCK); /* Full is an overrun */
+		} else	perror("pipe2()");
+		break;
+	}
+
+	if ( rc ) {
+		gpio_line_close(line);
+		return 0;
+	}
+	return line;
+}
+
+/*********************************************************************
+ * Request gpio as an output, initially at level. Returns 0 on failure.
+ *********************************************************************/
+gpio_line_t *
+gpio_line_output(int gpio,int level) {
+	gpio_line_t *line = line_alloc(gpio,0,0);
+	int rc = 0;
+
+	if ( !line )
+		return 0;
+
+	switch ( line->kind ) {
+	case line_chip :
+		rc = chip_request(line,1,level,0);
+		break;
+	case line_sysfs :
+		rc = sysfs_open(line,1,level);
+		break;
+	case line_sim :
+		break;
+	}
+	line->level = line->sim_level = level ? 1 : 0;
+
+	if ( rc ) {
+		gpio_line_close(line);
+		return 0;
+	}
+	return line;
+}
+
+/*********************************************************************
+ * Turn a line around without releasing it: drive it as an output at
+ * level, or return it to being an input reporting the edges it was
+ * requested with (events are not reported while an output). For
+ * protocols like the DHT11's that share one wire, the chip backend
+ * reconfigures the request in place, so no edges are missed while
+ * the line is requested again. Returns 0, or -1.
+ *********************************************************************/
+int
+gpio_line_direction(gpio_line_t *line,int output,int level) {
+	struct gpio_v2_line_config config;
+
+	switch ( line->kind ) {
+	case line_chip :
+		chip_config(line,output,level,line->debounce_us,&config);
+		if ( ioctl(line->fd,GPIO_V2_LINE_SET_CONFIG_IOCTL,&config) < 0 )
+			return -1;
+		break;
+	case line_sysfs :
+		if ( sysfs_put(line->gpio,"gpio%d/direction",output ? (level ? "high\n" : "low\n") : "in\n") )
+			return -1;
+		break;
+	case line_sim :
+		if ( output )
+			line->sim_level = level ? 1 : 0;
+		break;
+	}
+	line->level = output ? (level ? 1 : 0) : gpio_line_get(line);
+	return 0;
+}
+
+/*********************************************************************
+ * Release the line (sysfs: unexport it, if this line exported it)
+ *********************************************************************/
+void
+gpio_line_close(gpio_line_t *line) {
+	char buf[16];
+
+	if ( !line )
+		return;
+	if ( line->fd >= 0 )
+		close(line->fd);
+	if ( line->wfd >= 0 )
+		close(line->wfd);
+	if ( line->exported ) {
+		snprintf(buf,sizeof buf,"%d\n",line->gpio);
+		sysfs_put(line->gpio,"unexport",buf);
+	}
+	free(line);
+}
+
+/*********************************************************************
+ * Return the current level of the line, or -1
+ *********************************************************************/
+int
+gpio_line_get(gpio_line_t *line) {
+	struct gpio_v2_line_values values;
+	char buf[8];
+
+	switch ( line->kind ) {
+	case line_chip :
+		values.bits = 0;
+		values.mask = 1;
+		if ( ioctl(line->fd,GPIO_V2_LINE_GET_VALUES_IOCTL,&values) < 0 )
+			return -1;
+		return values.bits & 1;
+	case line_sysfs :
+		if ( lseek(line->fd,0,SEEK_SET) < 0 || read(line->fd,buf,sizeof buf) < 1 )
+			return -1;
+		return buf[0] == '1';
+	case line_sim :
+		break;
+	}
+	return line->sim_level;
+}
+
+/*********************************************************************
+ * Drive an output line to level. Returns 0, or -1
+ *********************************************************************/
+int
+gpio_line_set(gpio_line_t *line,int level) {
+	struct gpio_v2_line_values values;
+
+	switch ( line->kind ) {
+	case line_chip :
+		values.bits = level ? 1 : 0;
+		values.mask = 1;
+		if ( ioctl(line->fd,GPIO_V2_LINE_SET_VALUES_IOCTL,&values) < 0 )
+			return -1;
+		break;
+	case line_sysfs :
+		if ( write(line->fd,level ? "1\n" : "0\n",2) != 2 )
+			return -1;
+		break;
+	case line_sim :
+		line->sim_level = level ? 1 : 0;
+		break;
+	}
+	line->level = level ? 1 : 0;
+	return 0;
+}
+
+/*********************************************************************
+ * Wait until the CLOCK_MONOTONIC time deadline_ns (GPIO_FOREVER
+ * never expires) for edges, storing up to max of them. Returns the
+ * number stored, 0 once the deadline has passed, or -1 with errno
+ * set (EINTR when a signal arrived). Edges already queued are
+ * returned even when the deadline has passed, and edges debounced
+ * away do not extend the wait.
+ *********************************************************************/
+int
+gpio_line_wait_until(gpio_line_t *line,gpio_edge_t *edges,unsigned max,unsigned long long deadline_ns) {
+	struct pollfd pfd;
+	struct timespec ts, *tsp = 0;
+	unsigned long long now;
+	int rc, level;
+
+	if ( !max )
+		return 0;
+
+	pfd.fd = line->fd;
+	pfd.events = line->kind == line_sysfs ? POLLPRI : POLLIN;
+
+	for (;;) {
+		if ( deadline_ns != GPIO_FOREVER ) {
+			now = mono_ns();
+			now = deadline_ns > now ? deadline_ns - now : 0;
+			ts.tv_sec = now / 1000000000ULL;
+			ts.tv_nsec = now % 1000000000ULL;
+			tsp = &ts;
+		}
+		if ( (rc = ppoll(&pfd,1,tsp,0)) <= 0 )
+			return rc;
+
+		if ( line->kind != line_sysfs ) {
+			if ( (rc = chip_read(line,edges,max)) != 0 )
+				return rc;
+			continue;		/* All debounced away */
+		}
+
+		edges[0].ns = mono_ns();
+		if ( (level = gpio_line_get(line)) < 0 )
+			return -1;
+		if ( line->events != GPIO_EV_BOTH )
+			level = line->events == GPIO_EV_RISING;	/* One kind of edge */
+		else if ( level == line->level )
+			continue;		/* Change already reported */
+		if ( line->debounce_ns && edges[0].ns - line->last_ns < line->debounce_ns )
+			continue;
+		edges[0].gpio = line->gpio;
+		edges[0].level = line->level = level;
+		line->last_ns = edges[0].ns;
+		return 1;
+	}
+}
+
+/*********************************************************************
+ * Wait up to timeout_ms (< 0 is forever) for edges, storing up to
+ * max of them. Returns the number stored, 0 on timeout, or -1 with
+ * errno set (EINTR when a signal arrived).
+ *********************************************************************/
+int
+gpio_line_wait(gpio_line_t *line,gpio_edge_t *edges,unsigned max,int timeout_ms) {
+	return gpio_line_wait_until(line,edges,max,
+		timeout_ms < 0 ? GPIO_FOREVER : mono_ns() + timeout_ms * 1000000ULL);
+}
+
+/*********************************************************************
+ * CLOCK_MONOTONIC time in nanoseconds, the clock of edge timestamps
+ * and deadlines
+ *********************************************************************/
+unsigned long long
+gpio_line_now(void) {
+	return mono_ns();
+}
+
+int
+gpio_line_fd(gpio_line_t *line) {
+	return line->fd;
+}
+
+unsigned
+gpio_line_dropped(gpio_line_t *line) {
+	return line->dropped;
+}
+
+const char *
+gpio_line_backend(gpio_line_t *line) {
+	return kind_names[line->kind];
+}
+
+/*********************************************************************
+ * Stand-in for the kernel: queue an edge to level on a sim line, at
+ * time ns (0 for now). Edges the line does not report are ignored.
+ *********************************************************************/
+void
+gpio_line_sim_edge(gpio_line_t *line,int level,unsigned long long ns) {
+	struct gpio_v2_line_event kev;
+
+	if ( line->kind != line_sim || line->wfd < 0 )
+		return;
+	line->sim_level = level ? 1 : 0;
+	if ( !(line->events & (level ? GPIO_EV_RISING : GPIO_EV_FALLING)) )
+		return;
+
+	memset(&kev,0,sizeof kev);
+	kev.timestamp_ns = ns ? ns : mono_ns();
+	kev.id = level ? GPIO_V2_LINE_EVENT_RISING_EDGE : GPIO_V2_LINE_EVENT_FALLING_EDGE;
+	kev.offset = line->gpio;
+	kev.seqno = kev.line_seqno = ++line->sim_seqno;
+	(void)write(line->wfd,&kev,sizeof kev);	/* Pipe full: a seqno gap */
+}
+
+/*********************************************************************
+ * End gpio_line.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
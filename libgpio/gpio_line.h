@@ -0,0 +1,62 @@
+/*********************************************************************
+ * gpio_line.h : Kernel GPIO line access with edge events (libgpio)
+ *
+ * A gpio_line_t is one GPIO requested from the kernel, rather than
+ * through the mapped registers. Input lines report edges as
+ * gpio_edge_t records, several per gpio_line_wait() call.
+ *
+ * The backend is picked by GPIO_LINE (chip, sysfs or sim):
+ *
+ *	chip	/dev/gpiochipN line requests (GPIO_CHIP names the
+ *		device, default /dev/gpiochip0). Edges carry kernel
+ *		timestamps and the kernel debounces.
+ *	sysfs	/sys/class/gpio (deprecated): one poll() and one text
+ *		read per edge, timestamped on wakeup.
+ *	sim	A local stand-in fed by gpio_line_sim_edge(), delivering
+ *		records in the chip format.
+ *
+ * By default sim is used with GPIO_BACKEND=sim, then chip when the
+ * device exists, otherwise sysfs. Timestamps are CLOCK_MONOTONIC,
+ * as are the absolute deadlines of gpio_line_wait_until(), so a
+ * protocol can bound each phase from the timestamp of an edge.
+ *********************************************************************/
+
+#ifndef GPIO_LINE_H
+#define GPIO_LINE_H
+
+#include "gpio_io.h"		/* GPIO_EV_RISING, GPIO_EV_FALLING */
+
+typedef struct {
+	unsigned long long ns;	/* CLOCK_MONOTONIC time of the edge */
+	int		gpio;	/* GPIO that changed */
+	int		level;	/* Level after the edge */
+} gpio_edge_t;
+
+#define GPIO_FOREVER	(~0ULL)		/* Deadline that never passes */
+
+typedef struct gpio_line gpio_line_t;
+
+gpio_line_t *gpio_line_input(int gpio,unsigned events,unsigned debounce_us);
+gpio_line_t *gpio_line_output(int gpio,int level);
+void gpio_line_close(gpio_line_t *line);
+
+int gpio_line_get(gpio_line_t *line);		/* Level, or -1 */
+int gpio_line_set(gpio_line_t *line,int level);	/* 0 or -1 */
+int gpio_line_direction(gpio_line_t *line,int output,int level);
+int gpio_line_wait(gpio_line_t *line,gpio_edge_t *edges,unsigned max,int timeout_ms);
+int gpio_line_wait_until(gpio_line_t *line,gpio_edge_t *edges,unsigned max,unsigned long long deadline_ns);
+unsigned long long gpio_line_now(void);		/* CLOCK_MONOTONIC ns */
+
+int gpio_line_fd(gpio_line_t *line);		/* For poll(2) */
+unsigned gpio_line_dropped(gpio_line_t *line);	/* Edges lost to overrun */
+const char *gpio_line_backend(gpio_line_t *line);
+
+void gpio_line_sim_edge(gpio_line_t *line,int level,unsigned long long ns);
+
+#endif /* GPIO_LINE_H */
+
+/*********************************************************************
+ * End gpio_line.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
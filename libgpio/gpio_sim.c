@@ -0,0 +1,244 @@
+/*********************************************************************
+ * gpio_sim.c : Simulated GPIO register file (libgpio "sim" backend)
+ *
+ * Select it with GPIO_BACKEND=sim. The access log size defaults to
+ * 65536 records and may be changed with GPIO_SIM_LOG=<records>.
+ *********************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "gpio_io.h"
+#include "gpio_sim.h"
+
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static gpio_sim_rec_t *sim_log = 0;	/* Ring of access records */
+static unsigned log_size = 0;		/* Records in sim_log */
+static unsigned log_count = 0;		/* Records written */
+
+/*
+ * Internal : Create a memfd of size bytes and map it
+ */
+static void *
+memfd_map(const char *name,size_t size) {
+	int fd;
+	void *map;
+
+	fd = memfd_create(name,MFD_CLOEXEC);
+	if ( fd < 0 ) {
+		perror("memfd_create()");
+		return 0;
+	}
+	if ( ftruncate(fd,size) < 0 ) {
+		perror("ftruncate(memfd)");
+		close(fd);
+		return 0;
+	}
+
+	map = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+	close(fd);
+	if ( map == MAP_FAILED ) {
+		perror("mmap(memfd)");
+		return 0;
+	}
+	return map;
+}
+
+/*
+ * Internal : Allocate the access log once
+ */
+static void
+log_alloc(void) {
+	const char *env = getenv("GPIO_SIM_LOG");
+	unsigned size = env ? strtoul(env,0,10) : 65536;
+
+	if ( size < 1 )
+		size = 1;
+	sim_log = memfd_map("gpio_sim_log",size * sizeof *sim_log);
+	if ( sim_log )
+		log_size = size;
+}
+
+/*
+ * Internal : Append one record to the access log
+ */
+static void
+log_access(char op,unsigned reg,unsigned value) {
+	struct timespec ts;
+	gpio_sim_rec_t *rec;
+	unsigned n;
+
+	pthread_once(&log_once,log_alloc);
+	if ( !log_size )
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	n = __atomic_fetch_add(&log_count,1,__ATOMIC_RELAXED);
+	rec = &sim_log[n % log_size];
+	rec->ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	rec->reg = reg;
+	rec->op = op;
+	rec->value = value;
+}
+
+/*
+ * Internal : Mask of the GPIOs in bank whose function select is output
+ */
+static unsigned
+output_mask(unsigned bank) {
+	unsigned mask = 0, fsel;
+	int gpio;
+
+	for ( gpio=bank*32; gpio<GPIO_COUNT && gpio<(bank+1)*32; ++gpio ) {
+		fsel = (ugpio[GPFSEL0+gpio/10] >> (gpio % 10) * 3) & 7;
+		if ( fsel == 1 )
+			mask |= GPIO_BIT(gpio);
+	}
+	return mask;
+}
+
+/*
+ * Internal : Change the levels of a bank, latching enabled edges
+ * in GPEDSn as the event detect hardware would.
+ */
+static void
+sim_level(unsigned bank,unsigned level) {
+	unsigned old = ugpio[GPLEV0+bank];
+	unsigned rise = ~old & level, fall = old & ~level, ev;
+
+	ev = (rise & (ugpio[GPREN0+bank] | ugpio[GPAREN0+bank]))
+	   | (fall & (ugpio[GPFEN0+bank] | ugpio[GPAFEN0+bank]));
+	ugpio[GPLEV0+bank] = level;
+	if ( ev )
+		__atomic_fetch_or(&ugpio[GPEDS0+bank],ev,__ATOMIC_RELAXED);
+}
+
+/*********************************************************************
+ * Traced register read (GPIO_SIM_TRACE builds)
+ *********************************************************************/
+unsigned
+gpio_sim_rd(unsigned reg) {
+	unsigned value = ugpio[reg];
+
+	log_access('R',reg,value);
+	return value;
+}
+
+/*********************************************************************
+ * Traced register write (GPIO_SIM_TRACE builds). With the simulated
+ * backend, GPSETn/GPCLRn change GPLEVn for output pins and GPEDSn
+ * is write 1 to clear, as on the hardware. Other backends just see
+ * the store.
+ *********************************************************************/
+void
+gpio_sim_wr(unsigned reg,unsigned value) {
+
+	log_access('W',reg,value);
+
+	if ( gpio_get_backend() != &gpio_backend_sim ) {
+		ugpio[reg] = value;
+		return;
+	}
+
+	switch ( reg ) {
+	case GPSET0 :
+	case GPSET1 :
+		reg -= GPSET0;
+		sim_level(reg,ugpio[GPLEV0+reg] | (value & output_mask(reg)));
+		break;
+	case GPCLR0 :
+	case GPCLR1 :
+		reg -= GPCLR0;
+		sim_level(reg,ugpio[GPLEV0+reg] & ~(value & output_mask(reg)));
+		break;
+	case GPEDS0 :
+	case GPEDS1 :
+		__atomic_fetch_and(&ugpio[reg],~value,__ATOMIC_RELAXED);
+		break;
+	default :
+		ugpio[reg] = value;
+	}
+}
+
+/*********************************************************************
+ * Drive a simulated input pin level (GPIOs 0-53), latching an
+ * event if one is enabled for the edge
+ *********************************************************************/
+void
+gpio_sim_input(int gpio,int level) {
+	unsigned bank = GPIO_BANK(gpio);
+
+	if ( level )
+		sim_level(bank,ugpio[GPLEV0+bank] | GPIO_BIT(gpio));
+	else	sim_level(bank,ugpio[GPLEV0+bank] & ~GPIO_BIT(gpio));
+}
+
+unsigned
+gpio_sim_count(void) {
+	return __atomic_load_n(&log_count,__ATOMIC_RELAXED);
+}
+
+/*********************************************************************
+ * Return record n, or 0 if it was never written or has been
+ * overwritten by the wrapping log.
+ *********************************************************************/
+const gpio_sim_rec_t *
+gpio_sim_record(unsigned n) {
+	unsigned count = gpio_sim_count();
+
+	if ( !log_size || n >= count || count - n > log_size )
+		return 0;
+	return &sim_log[n % log_size];
+}
+
+void
+gpio_sim_reset(void) {
+	__atomic_store_n(&log_count,0,__ATOMIC_RELAXED);
+}
+
+/*********************************************************************
+ * Print the logged accesses, with times relative to the first
+ *********************************************************************/
+void
+gpio_sim_dump(FILE *f) {
+	unsigned count = gpio_sim_count(), n;
+	unsigned first = count > log_size ? count - log_size : 0;
+	const gpio_sim_rec_t *rec, *r0 = gpio_sim_record(first);
+
+	for ( n=first; n<count; ++n ) {
+		rec = gpio_sim_record(n);
+		fprintf(f,"%12.3f us  %c  reg %2u  0x%08X\n",
+			(rec->ns - r0->ns) / 1000.0,rec->op,rec->reg,rec->value);
+	}
+}
+
+/*********************************************************************
+ * Simulated backend : each peripheral block is a zeroed memfd page.
+ *********************************************************************/
+static volatile unsigned *
+sim_map(unsigned long offset) {
+	char name[32];
+
+	snprintf(name,sizeof name,"gpio_sim_%06lX",offset);
+	return (volatile unsigned *)memfd_map(name,BLOCK_SIZE);
+}
+
+static void
+sim_unmap(volatile unsigned *regs) {
+	munmap((void *)regs,BLOCK_SIZE);
+}
+
+const gpio_backend_t gpio_backend_sim = {
+	"sim", sim_map, sim_unmap
+};
+
+/*********************************************************************
+ * End gpio_sim.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,38 @@
+/*********************************************************************
+ * gpio_sim.h : Simulated GPIO register file (libgpio "sim" backend)
+ *
+ * Each mapped peripheral block is an ordinary page of memfd backed
+ * memory, so the bit-banging code runs unchanged on any Linux box.
+ * Tools compiled with -DGPIO_SIM_TRACE also log every GPIO register
+ * access with a CLOCK_MONOTONIC timestamp, and writes to GPSET/GPCLR
+ * are reflected in GPLEV for pins configured as outputs.
+ *********************************************************************/
+
+#ifndef GPIO_SIM_H
+#define GPIO_SIM_H
+
+#include <stdio.h>
+
+typedef struct {
+	unsigned long long	ns;	/* CLOCK_MONOTONIC time of access */
+	unsigned short		reg;	/* GPIO register word index */
+	char			op;	/* 'R' or 'W' */
+	unsigned		value;	/* Value read or written */
+} gpio_sim_rec_t;
+
+unsigned gpio_sim_rd(unsigned reg);		/* Traced accesses */
+void gpio_sim_wr(unsigned reg,unsigned value);
+
+void gpio_sim_input(int gpio,int level);	/* Drive a simulated input */
+unsigned gpio_sim_count(void);			/* Accesses logged so far */
+const gpio_sim_rec_t *gpio_sim_record(unsigned n); /* Record n or 0 */
+void gpio_sim_reset(void);			/* Discard the log */
+void gpio_sim_dump(FILE *f);			/* Print the log */
+
+#endif /* GPIO_SIM_H */
+
+/*********************************************************************
+ * End gpio_sim.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,148 @@
+/*********************************************************************
+ * gpio_time.c : Calibrated nanosecond timestamps and delays (libgpio)
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "gpio_io.h"
+#include "gpio_time.h"
+
+static pthread_once_t cal_once = PTHREAD_ONCE_INIT;
+static gpio_time_cal_t cal = { "clock", 0, 1, 0.0 };
+static volatile unsigned *systimer = 0;	/* Mapped system timer or 0 */
+
+/*
+ * Internal : Spin n times (for delays below one clock read)
+ */
+static void
+spin(unsigned long n) {
+	volatile unsigned long x;
+
+	for ( x=0; x<n; ++x )
+		;
+}
+
+/*********************************************************************
+ * Return a monotonic timestamp in nanoseconds. The system timer
+ * counts microseconds; its high word is re-read in case the low
+ * word wrapped between the two loads.
+ *********************************************************************/
+unsigned long long
+gpio_ns(void) {
+	struct timespec ts;
+	unsigned hi, lo;
+
+	if ( systimer ) {
+		do	{
+			hi = systimer[SYSTIMER_CHI];
+			lo = systimer[SYSTIMER_CLO];
+		} while ( hi != systimer[SYSTIMER_CHI] );
+		return ((unsigned long long)hi << 32 | lo) * 1000ULL;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC_RAW,&ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Internal : Select the time source and calibrate (once only)
+ */
+static void
+calibrate(void) {
+	const char *source = getenv("GPIO_TIME");
+	unsigned long long t0, t1;
+	unsigned long n;
+	struct timespec res;
+	unsigned x;
+
+	if ( source && !strcmp(source,"systimer") ) {
+		gpio_init();			/* Reference held for good */
+		if ( !strcmp(gpio_get_backend()->name,"sim") ) {
+			fprintf(stderr,"gpio_time: no system timer in the simulator, using clock\n");
+		} else if ( !(systimer = gpio_map_peri(SYSTIMER_OFFSET)) ) {
+			fprintf(stderr,"gpio_time: system timer not mapped, using clock\n");
+		} else	{
+			cal.source = "systimer";
+			cal.res_ns = 1000;
+		}
+	} else if ( source && strcmp(source,"clock") ) {
+		fprintf(stderr,"gpio_time: unknown GPIO_TIME '%s', using clock\n",source);
+	}
+
+	if ( !systimer && !clock_getres(CLOCK_MONOTONIC_RAW,&res) )
+		cal.res_ns = res.tv_sec * 1000000000U + res.tv_nsec;
+
+	/* Average cost of reading the time source */
+	t0 = gpio_ns();
+	for ( x=0; x<10000; ++x )
+		(void)gpio_ns();
+	t1 = gpio_ns();
+	cal.read_ns = (t1 - t0) / 10000;
+
+	/* Spin loop rate, timed over at least 2 ms */
+	for ( n=10000;; n *= 2 ) {
+		t0 = gpio_ns();
+		spin(n);
+		t1 = gpio_ns();
+		if ( t1 - t0 >= 2000000 )
+			break;
+	}
+	cal.spins_per_ns = (double)n / (t1 - t0);
+}
+
+/*********************************************************************
+ * Calibrate now rather than on the first delay
+ *********************************************************************/
+void
+gpio_time_init(void) {
+	pthread_once(&cal_once,calibrate);
+}
+
+/*********************************************************************
+ * Return the calibration results
+ *********************************************************************/
+const gpio_time_cal_t *
+gpio_time_cal(void) {
+	gpio_time_init();
+	return &cal;
+}
+
+/*********************************************************************
+ * Busy wait for ns nanoseconds. Delays shorter than one clock read
+ * use the calibrated spin loop, and delays over GPIO_SLEEP_NS sleep
+ * for all but the last GPIO_SLEEP_NS before spinning on the clock.
+ *********************************************************************/
+void
+gpio_delay_ns(unsigned long ns) {
+	struct timespec ts;
+	unsigned long long t_end;
+
+	gpio_time_init();
+
+	if ( ns < cal.read_ns + cal.res_ns ) {
+		spin(ns * cal.spins_per_ns);
+		return;
+	}
+
+	t_end = gpio_ns() + ns - cal.read_ns;	/* Less the final read */
+
+	if ( ns > GPIO_SLEEP_NS ) {
+		ns -= GPIO_SLEEP_NS;
+		ts.tv_sec = ns / 1000000000UL;
+		ts.tv_nsec = ns % 1000000000UL;
+		clock_nanosleep(CLOCK_MONOTONIC,0,&ts,0);
+	}
+
+	while ( gpio_ns() < t_end )
+		;
+}
+
+/*********************************************************************
+ * End gpio_time.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
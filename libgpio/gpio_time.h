@@ -0,0 +1,43 @@
+/*********************************************************************
+ * gpio_time.h : Calibrated nanosecond timestamps and delays (libgpio)
+ *
+ * gpio_ns() returns a monotonic timestamp and gpio_delay_ns() busy
+ * waits on it, so that protocol timing does not depend upon the CPU
+ * clock rate. The time source is CLOCK_MONOTONIC_RAW, or the BCM2835
+ * free running system timer (1 MHz) when GPIO_TIME=systimer.
+ *
+ * gpio_time_init() is called on first use. It measures the cost of
+ * reading the time source and the speed of a spin loop, which covers
+ * delays shorter than one clock read.
+ *********************************************************************/
+
+#ifndef GPIO_TIME_H
+#define GPIO_TIME_H
+
+#define SYSTIMER_OFFSET	0x3000		/* System timer from peripheral base */
+#define SYSTIMER_CLO	1		/* Counter low word (word index) */
+#define SYSTIMER_CHI	2		/* Counter high word */
+
+#define GPIO_SLEEP_NS	200000		/* Longer delays sleep for most of it */
+
+typedef struct {
+	const char	*source;	/* "clock" or "systimer" */
+	unsigned	read_ns;	/* Cost of one gpio_ns() call */
+	unsigned	res_ns;		/* Time source resolution */
+	double		spins_per_ns;	/* Spin loop rate for short delays */
+} gpio_time_cal_t;
+
+void gpio_time_init(void);
+const gpio_time_cal_t *gpio_time_cal(void);
+unsigned long long gpio_ns(void);
+void gpio_delay_ns(unsigned long ns);
+
+#define gpio_delay_us(us) gpio_delay_ns((unsigned long)(us) * 1000UL)
+
+#endif /* GPIO_TIME_H */
+
+/*********************************************************************
+ * End gpio_time.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
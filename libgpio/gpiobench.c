@@ -0,0 +1,253 @@
+/*********************************************************************
+ * gpiobench.c : Micro-benchmarks of the libgpio hot paths
+ *
+ * ./gpiobench [-n count] [test ...]
+ *
+ * Runs on the simulated backend unless GPIO_BACKEND says otherwise,
+ * so the numbers measure the instruction path rather than the MMIO
+ * bus. Build with DBG=-O2 to see the optimized code paths.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "gpio_io.h"
+#include "gpio_time.h"
+
+GPIO_PIN(bench_gpio,22);		/* Compile time pin */
+static int bench_pin = 22;		/* Run time pin */
+static unsigned long count = 10000000;	/* Iterations per test */
+
+/*
+ * Return the current time in seconds :
+ */
+static double
+now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Report the rate for ops operations over t0 to now :
+ */
+static void
+report(const char *what,double t0,unsigned long ops) {
+	double secs = now() - t0;
+
+	printf("  %-36s %12.0f /sec  %7.2f ns each\n",what,ops/secs,secs*1e9/ops);
+}
+
+/*********************************************************************
+ * Toggle a pin: run time pin number vs GPIO_PIN() specialization
+ *********************************************************************/
+static void
+bench_toggle(void) {
+	unsigned long x;
+	double t0;
+
+	bench_gpio_config(Output);
+
+	t0 = now();
+	for ( x=0; x<count; ++x ) {
+		gpio_write(bench_pin,1);
+		gpio_write(bench_pin,0);
+	}
+	report("gpio_write(pin,bit)",t0,count*2);
+
+	t0 = now();
+	for ( x=0; x<count; ++x ) {
+		bench_gpio_write(1);
+		bench_gpio_write(0);
+	}
+	report("GPIO_PIN name_write(bit)",t0,count*2);
+
+	t0 = now();
+	for ( x=0; x<count; ++x ) {
+		bench_gpio_set();
+		bench_gpio_clr();
+	}
+	report("GPIO_PIN name_set()/name_clr()",t0,count*2);
+
+	t0 = now();
+	for ( x=0; x<count; ++x )
+		(void)gpio_read(bench_pin);
+	report("gpio_read(pin)",t0,count);
+
+	t0 = now();
+	for ( x=0; x<count; ++x )
+		(void)bench_gpio_read();
+	report("GPIO_PIN name_read()",t0,count);
+}
+
+/*********************************************************************
+ * Configure the five PCD8544 pins as outputs: the old INP_GPIO +
+ * OUT_GPIO pair per pin vs one locked gpio_fsel_commit()
+ *********************************************************************/
+static void
+bench_fsel(void) {
+	static const int pins[] = { 25, 23, 17, 27, 22 };
+	unsigned long x, n = count / 100 + 1;
+	gpio_fsel_t tx;
+	double t0;
+	int p;
+
+	t0 = now();
+	for ( x=0; x<n; ++x )
+		for ( p=0; p<5; ++p ) {
+			INP_GPIO(pins[p]);
+			OUT_GPIO(pins[p]);
+		}
+	report("INP_GPIO+OUT_GPIO x5 (unlocked)",t0,n);
+
+	t0 = now();
+	for ( x=0; x<n; ++x ) {
+		gpio_fsel_begin(&tx);
+		for ( p=0; p<5; ++p )
+			gpio_fsel_dir(&tx,pins[p],Output);
+		gpio_fsel_commit(&tx);
+	}
+	report("gpio_fsel_commit() x5 (locked)",t0,n);
+}
+
+/*********************************************************************
+ * Read all 54 levels: gpio_read() per pin vs one two-load snapshot
+ *********************************************************************/
+static void
+bench_snapshot(void) {
+	unsigned long x, n = count / 10 + 1;
+	unsigned long long levels = 0;
+	double t0;
+	int g;
+
+	t0 = now();
+	for ( x=0; x<n; ++x )
+		for ( g=0; g<GPIO_COUNT; ++g )
+			levels |= (unsigned long long)gpio_read(g) << g;
+	report("gpio_read(pin) x54",t0,n);
+
+	t0 = now();
+	for ( x=0; x<n; ++x )
+		levels ^= gpio_read_all64();
+	report("gpio_read_all64()",t0,n);
+
+	if ( levels == 1 )
+		puts("");		/* Keep levels live */
+}
+
+/*
+ * qsort() comparison of long long :
+ */
+static int
+cmp_ll(const void *a,const void *b) {
+	long long la = *(const long long *)a, lb = *(const long long *)b;
+
+	return la < lb ? -1 : la > lb;
+}
+
+/*********************************************************************
+ * Calibrated delays: print the error of gpio_delay_ns() against the
+ * requested delay, as percentiles over many trials
+ *********************************************************************/
+static void
+bench_delay(void) {
+	static const unsigned long targets[] = { 100, 1000, 10000, 100000, 1000000 };
+	const gpio_time_cal_t *c = gpio_time_cal();
+	unsigned n = count < 1000 ? count : 1000;
+	unsigned long long t0;
+	long long *err;
+	unsigned t, x;
+
+	printf("  source %s, read %u ns, resolution %u ns, %.3f spins/ns\n",
+		c->source,c->read_ns,c->res_ns,c->spins_per_ns);
+	printf("  %10s %10s %10s %10s %10s %10s\n","delay ns","min","p50","p90","p99","max");
+
+	err = malloc(n * sizeof *err);
+	for ( t=0; t<sizeof targets/sizeof targets[0]; ++t ) {
+		for ( x=0; x<n; ++x ) {
+			t0 = gpio_ns();
+			gpio_delay_ns(targets[t]);
+			err[x] = (long long)(gpio_ns() - t0) - (long long)targets[t];
+		}
+		qsort(err,n,sizeof *err,cmp_ll);
+		printf("  %10lu %+10lld %+10lld %+10lld %+10lld %+10lld\n",targets[t],
+			err[0],err[n/2],err[n*9/10],err[n*99/100],err[n-1]);
+	}
+	free(err);
+}
+
+static struct {
+	const char	*name;		/* Test name */
+	void		(*func)(void);	/* Test routine */
+	const char	*desc;		/* Description */
+} tests[] = {
+	{ "toggle",	bench_toggle,	"pin toggles, run time vs compile time pin" },
+	{ "fsel",	bench_fsel,	"five pin output configuration" },
+	{ "snapshot",	bench_snapshot,	"all 54 levels, per pin vs snapshot" },
+	{ "delay",	bench_delay,	"gpio_delay_ns() error percentiles" },
+	{ 0, 0, 0 }
+};
+
+/*
+ * Run one named test :
+ */
+static int
+run(const char *name) {
+	int tx;
+
+	for ( tx=0; tests[tx].name; ++tx )
+		if ( !strcmp(tests[tx].name,name) ) {
+			printf("%s: %s\n",tests[tx].name,tests[tx].desc);
+			tests[tx].func();
+			return 0;
+		}
+	fprintf(stderr,"Unknown test '%s'\n",name);
+	return 1;
+}
+
+/*
+ * Main program :
+ */
+int
+main(int argc,char **argv) {
+	int optch, tx, rc = 0;
+
+	while ( (optch = getopt(argc,argv,"n:h")) != EOF )
+		switch ( optch ) {
+		case 'n' :
+			count = strtoul(optarg,0,10);
+			break;
+		case 'h' :
+		default :
+			fprintf(stderr,"Usage: %s [-n count] [test ...]\nTests:\n",argv[0]);
+			for ( tx=0; tests[tx].name; ++tx )
+				fprintf(stderr,"  %-10s %s\n",tests[tx].name,tests[tx].desc);
+			return 1;
+		}
+
+	if ( !getenv("GPIO_BACKEND") )
+		gpio_select_backend("sim");
+	gpio_init();
+	printf("Backend %s, %lu iterations per test\n",gpio_get_backend()->name,count);
+
+	if ( optind >= argc ) {
+		for ( tx=0; tests[tx].name; ++tx )
+			rc |= run(tests[tx].name);
+	} else	{
+		for ( ; optind < argc; ++optind )
+			rc |= run(argv[optind]);
+	}
+
+	gpio_fini();
+	return rc;
+}
+
+/*********************************************************************
+ * End gpiobench.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,329 @@
+/*********************************************************************
+ * pwm_io.c : BCM2835 PWM, both channels, FIFO and DMA (libgpio)
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gpio_io.h"
+#include "pwm_io.h"
+
+static volatile unsigned *pwm = 0;	/* PWM registers */
+static volatile unsigned *clk = 0;	/* Clock manager */
+
+static const struct {
+	int	ch;			/* Channel */
+	int	gpio;			/* Pin */
+	int	alt;			/* Alternate function */
+} pwm_pins[] = {
+	{ 1, 12, 0 }, { 1, 18, 5 }, { 1, 40, 0 }, { 1, 52, 1 },
+	{ 2, 13, 0 }, { 2, 19, 5 }, { 2, 41, 0 }, { 2, 45, 0 }, { 2, 53, 1 }
+};
+
+struct pwm_stream {
+	volatile unsigned *dma;		/* DMA channel registers */
+	dma_mem_t	mem;		/* Control blocks, then words */
+	dma_cb_t	*cbs;		/* Control blocks */
+	unsigned	ncbs;
+	unsigned	*words;		/* Sample words */
+	unsigned	max_words;
+};
+
+/*********************************************************************
+ * Initialize GPIO/PWM/CLK Access. Returns 0, or -1 if the PWM or
+ * clock registers cannot be mapped.
+ *********************************************************************/
+int
+pwm_init(void) {
+
+	gpio_init();			/* Access to GPIO */
+
+	if ( !(pwm = gpio_map_peri(PWM_OFFSET)) )
+		return -1;
+	if ( !(clk = gpio_map_peri(CLK_OFFSET)) )
+		return -1;
+	return 0;
+}
+
+/*
+ * Internal : Wait (briefly) for the PWM clock generator to stop
+ */
+static void
+clock_idle(void) {
+	int x;
+
+	for ( x=0; x<100 && (PERI_RD(clk,PWMCLK_CNTL) & CLK_BUSY); ++x )
+		usleep(1);
+}
+
+/*********************************************************************
+ * Set the PWM clock, stopping both channels (pwm_start() them
+ * again). Returns 0, or -1 (+1) when the divisor had to be clamped
+ * at its lowest (highest).
+ *********************************************************************/
+int
+pwm_clock(float freq) {
+	long idiv;
+	int rc = 0;
+
+	PERI_WR(pwm,PWM_CTL,PERI_RD(pwm,PWM_CTL) & ~(PWM_PWEN(1)|PWM_PWEN(2)));
+
+	PERI_WR(clk,PWMCLK_CNTL,CLK_PASSWD|CLK_KILL);	/* Kill clock */
+	usleep(10);
+	clock_idle();
+
+	/*
+	 * Compute and set the divisor :
+	 */
+	idiv = (long) ( PWM_CLOCK_HZ / (double) freq );
+	if ( idiv < 1 ) {
+		idiv = 1;			/* Lowest divisor */
+		rc = -1;
+	} else if ( idiv >= 0x1000 ) {
+		idiv = 0xFFF;			/* Highest divisor */
+		rc = +1;
+	}
+	PERI_WR(clk,PWMCLK_DIV,CLK_PASSWD|idiv << 12);
+
+	/*
+	 * Set source to oscillator and enable clock:
+	 */
+	PERI_WR(clk,PWMCLK_CNTL,CLK_PASSWD|CLK_SRC_OSC);
+	PERI_WR(clk,PWMCLK_CNTL,CLK_PASSWD|CLK_SRC_OSC|CLK_ENAB);
+	return rc;
+}
+
+/*********************************************************************
+ * Route channel ch (1 or 2) to gpio and configure it, stopped.
+ * Returns 0, or -1 (reported) if gpio is not one of its pins.
+ *********************************************************************/
+int
+pwm_channel(int ch,int gpio,pwm_mode_t mode,unsigned flags) {
+	gpio_fsel_t tx;
+	unsigned x, ctl;
+
+	for ( x=0; x<sizeof pwm_pins / sizeof pwm_pins[0]; ++x )
+		if ( pwm_pins[x].ch == ch && pwm_pins[x].gpio == gpio )
+			break;
+	if ( x >= sizeof pwm_pins / sizeof pwm_pins[0] ) {
+		fprintf(stderr,"GPIO %d is not a pin of PWM channel %d\n",gpio,ch);
+		return -1;
+	}
+
+	gpio_fsel_begin(&tx);
+	gpio_fsel_alt(&tx,gpio,pwm_pins[x].alt);
+	if ( gpio_fsel_commit(&tx) )
+		return -1;			/* Lock failed (reported) */
+
+	ctl = PERI_RD(pwm,PWM_CTL) & ~(0xFF << PWM_CTL_SHIFT(ch)) & ~PWM_CLRF;
+	if ( mode == pwm_mode_serial )
+		ctl |= PWM_MODE(ch);
+	else if ( mode == pwm_mode_ms )
+		ctl |= PWM_MSEN(ch);
+	if ( flags & PWM_FIFO )
+		ctl |= PWM_USEF(ch);
+	if ( flags & PWM_REPEAT )
+		ctl |= PWM_RPTL(ch);
+	if ( flags & PWM_SILENCE_HIGH )
+		ctl |= PWM_SBIT(ch);
+	if ( flags & PWM_INVERT )
+		ctl |= PWM_POLA(ch);
+	PERI_WR(pwm,PWM_CTL,ctl);
+	PERI_WR(pwm,PWM_STA,PWM_STA_ERRORS);	/* Clear old errors */
+	return 0;
+}
+
+/*********************************************************************
+ * Set channel ch's data and range registers
+ *********************************************************************/
+void
+pwm_set(int ch,unsigned data,unsigned range) {
+	PERI_WR(pwm,ch == 2 ? PWM_RNG2 : PWM_RNG1,range);
+	PERI_WR(pwm,ch == 2 ? PWM_DAT2 : PWM_DAT1,data);
+}
+
+/*********************************************************************
+ * Start or stop channel ch: one register write, for gating
+ *********************************************************************/
+void
+pwm_start(int ch,int on) {
+	unsigned ctl = PERI_RD(pwm,PWM_CTL) & ~PWM_CLRF;
+
+	PERI_WR(pwm,PWM_CTL,on ? ctl | PWM_PWEN(ch) : ctl & ~PWM_PWEN(ch));
+}
+
+unsigned
+pwm_status(void) {
+	return PERI_RD(pwm,PWM_STA);
+}
+
+/*********************************************************************
+ * Empty the FIFO
+ *********************************************************************/
+void
+pwm_fifo_clear(void) {
+	PERI_WR(pwm,PWM_CTL,PERI_RD(pwm,PWM_CTL) | PWM_CLRF);
+}
+
+/*********************************************************************
+ * Write words to the FIFO until it fills. Returns the number taken.
+ *********************************************************************/
+unsigned
+pwm_fifo_write(const unsigned *words,unsigned n) {
+	unsigned x;
+
+	for ( x=0; x<n && !(PERI_RD(pwm,PWM_STA) & PWM_STA_FULL); ++x )
+		PERI_WR(pwm,PWM_FIF1,words[x]);
+	return x;
+}
+
+/*********************************************************************
+ * Prepare DMA channel dma_chan to feed the FIFO up to max_words per
+ * pwm_stream_play(). Returns 0 on failure (reported).
+ *********************************************************************/
+pwm_stream_t *
+pwm_stream_open(int dma_chan,unsigned max_words) {
+	pwm_stream_t *st = calloc(1,sizeof *st);
+	unsigned bytes = max_words * 4;
+
+	if ( !st || !max_words ) {
+		free(st);
+		return 0;
+	}
+	st->max_words = max_words;
+	st->ncbs = (bytes + DMA_LITE_MAX - 1) / DMA_LITE_MAX;
+	if ( !(st->dma = dma_channel(dma_chan))
+	  || dma_mem_alloc(&st->mem,st->ncbs * sizeof(dma_cb_t) + bytes) ) {
+		free(st);
+		return 0;
+	}
+	st->cbs = (dma_cb_t *)st->mem.virt;
+	st->words = (unsigned *)(st->cbs + st->ncbs);
+	return st;
+}
+
+/*********************************************************************
+ * Play n words through the FIFO, once or (loop) until stopped. The
+ * channels taking them must have been set up with PWM_FIFO and
+ * started. Returns 0, or -1 if n is more than max_words.
+ *********************************************************************/
+int
+pwm_stream_play(pwm_stream_t *st,const unsigned *words,unsigned n,int loop) {
+	unsigned x, off, len, ncbs;
+	dma_cb_t *cb;
+
+	if ( n > st->max_words || !n )
+		return -1;
+
+	dma_stop(st->dma);
+	memcpy(st->words,words,n * 4);
+
+	for ( ncbs=0, off=0; off < n * 4; off += len, ++ncbs ) {
+		len = n * 4 - off;
+		if ( len > DMA_LITE_MAX )
+			len = DMA_LITE_MAX;
+		cb = &st->cbs[ncbs];
+		cb->ti = DMA_TI_NO_WIDE | DMA_TI_WAIT_RESP | DMA_TI_DEST_DREQ
+			| DMA_TI_PERMAP(DMA_DREQ_PWM) | DMA_TI_SRC_INC;
+		cb->source_ad = dma_bus(&st->mem,(char *)st->words + off);
+		cb->dest_ad = dma_peri_bus(PWM_OFFSET,PWM_FIF1);
+		cb->txfr_len = len;
+		cb->stride = 0;
+		cb->nextconbk = 0;
+	}
+	for ( x=0; x+1<ncbs; ++x )
+		st->cbs[x].nextconbk = dma_bus(&st->mem,&st->cbs[x+1]);
+	if ( loop )
+		st->cbs[ncbs-1].nextconbk = dma_bus(&st->mem,&st->cbs[0]);
+
+	PERI_WR(pwm,PWM_DMAC,PWM_DMAC_ENAB|PWM_DMAC_PANIC(7)|PWM_DMAC_DREQ(3));
+	pwm_fifo_clear();
+	dma_start(st->dma,dma_bus(&st->mem,&st->cbs[0]));
+	return 0;
+}
+
+/*********************************************************************
+ * True while words remain to be fed (always, when looping)
+ *********************************************************************/
+int
+pwm_stream_busy(pwm_stream_t *st) {
+	return dma_busy(st->dma);
+}
+
+/*********************************************************************
+ * Stop feeding the FIFO (the channels keep their last settings)
+ *********************************************************************/
+void
+pwm_stream_stop(pwm_stream_t *st) {
+	dma_stop(st->dma);
+	PERI_WR(pwm,PWM_DMAC,0);
+}
+
+void
+pwm_stream_close(pwm_stream_t *st) {
+	pwm_stream_stop(st);
+	dma_mem_free(&st->mem);
+	free(st);
+}
+
+const dma_mem_t *
+pwm_stream_mem(pwm_stream_t *st) {
+	return &st->mem;
+}
+
+/*********************************************************************
+ * Establish the PWM frequency of channel 1 on GPIO 18, in PWM mode
+ * and stopped. Returns 0, or -1 (+1) when the divisor had to be
+ * clamped at its lowest (highest).
+ *********************************************************************/
+int
+pwm_frequency(float freq) {
+	int rc = pwm_clock(freq);
+
+	if ( pwm_channel(1,18,pwm_mode_pwm,0) )
+		exit(1);			/* Lock failed (reported) */
+	pwm_fifo_clear();
+	return rc;
+}
+
+/*********************************************************************
+ * Set channel 1 to ratio N/M, and enable it:
+ *********************************************************************/
+void
+pwm_ratio(unsigned n,unsigned m) {
+
+	pwm_start(1,0);			/* Disable */
+	pwm_set(1,n,m);
+
+	if ( !(PERI_RD(pwm,PWM_STA) & PWM_STA_STA(1)) )
+		PERI_WR(pwm,PWM_STA,PERI_RD(pwm,PWM_STA) & (PWM_STA_RERR|PWM_STA_WERR|PWM_STA_BERR));
+
+	usleep(10);			/* Pause */
+	pwm_start(1,1);			/* Enable */
+}
+
+/*********************************************************************
+ * Select mark-space (1) or PWM (0) mode on channel 1
+ *********************************************************************/
+void
+pwm_markspace(int on) {
+	unsigned ctl = PERI_RD(pwm,PWM_CTL) & ~PWM_CLRF;
+
+	PERI_WR(pwm,PWM_CTL,on ? ctl | PWM_MSEN(1) : ctl & ~PWM_MSEN(1));
+}
+
+/*********************************************************************
+ * Start or stop channel 1: one register write, for gating a carrier
+ *********************************************************************/
+void
+pwm_enable(int on) {
+	pwm_start(1,on);
+}
+
+/*********************************************************************
+ * End pwm_io.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,136 @@
+/*********************************************************************
+ * pwm_io.h : BCM2835 PWM, both channels, FIFO and DMA (libgpio)
+ *
+ * pwm_clock() sets the PWM clock shared by both channels: one step
+ * of the range, or one bit in serializer mode. pwm_channel() routes
+ * a channel to one of its pins and picks its mode:
+ *
+ *	pwm_mode_pwm	the data/range high steps spread evenly over
+ *			the range (the BCM's PWM algorithm)
+ *	pwm_mode_ms	mark-space: data steps high, then the rest of
+ *			the range low, i.e. a plain duty cycle
+ *	pwm_mode_serial	each data word is shifted out MSB first, range
+ *			bits (up to 32) per word
+ *
+ * The data comes from the channel's data register (pwm_set()), or
+ * with PWM_FIFO from the 16 word FIFO shared by both channels (they
+ * take alternate words when both use it). pwm_fifo_write() feeds it
+ * from the CPU; a pwm_stream_t feeds it by DMA (dma_io.h), so audio
+ * samples, servo positions or WS2812 bit streams play with no CPU
+ * involvement, once or in a loop.
+ *
+ * Channel 1 is on GPIO 12, 18, 40 or 52, channel 2 on GPIO 13, 19,
+ * 41, 45 or 53. pwm_frequency(), pwm_ratio(), pwm_markspace() and
+ * pwm_enable() are the original channel 1 on GPIO 18 interface.
+ *********************************************************************/
+
+#ifndef PWM_IO_H
+#define PWM_IO_H
+
+#include "dma_io.h"			/* dma_mem_t */
+
+#define PWM_OFFSET	0x20C000	/* PWM from PERI_BASE */
+#define CLK_OFFSET	0x101000	/* CLK from PERI_BASE */
+
+/*
+ * PWM register word indexes :
+ */
+#define PWM_CTL		0		/* Control */
+#define PWM_STA		1		/* Status */
+#define PWM_DMAC	2		/* DMA configuration */
+#define PWM_RNG1	4		/* Channel 1 range */
+#define PWM_DAT1	5		/* Channel 1 data */
+#define PWM_FIF1	6		/* FIFO input */
+#define PWM_RNG2	8		/* Channel 2 range */
+#define PWM_DAT2	9		/* Channel 2 data */
+
+#define BCM2835_PWM_CONTROL	PWM_CTL	/* Original names */
+#define BCM2835_PWM_STATUS	PWM_STA
+#define BCM2835_PWM0_RANGE	PWM_RNG1
+#define BCM2835_PWM0_DATA	PWM_DAT1
+
+/* PWM_CTL bits for channel ch (1 or 2) */
+#define PWM_CTL_SHIFT(ch) (((ch) - 1) * 8)
+#define PWM_PWEN(ch)	(0x01 << PWM_CTL_SHIFT(ch))	/* Enable */
+#define PWM_MODE(ch)	(0x02 << PWM_CTL_SHIFT(ch))	/* Serializer */
+#define PWM_RPTL(ch)	(0x04 << PWM_CTL_SHIFT(ch))	/* Repeat last word */
+#define PWM_SBIT(ch)	(0x08 << PWM_CTL_SHIFT(ch))	/* Silence is high */
+#define PWM_POLA(ch)	(0x10 << PWM_CTL_SHIFT(ch))	/* Invert */
+#define PWM_USEF(ch)	(0x20 << PWM_CTL_SHIFT(ch))	/* Data from FIFO */
+#define PWM_MSEN(ch)	(0x80 << PWM_CTL_SHIFT(ch))	/* Mark-space */
+#define PWM_CLRF	0x40				/* Clear FIFO */
+
+/* PWM_STA bits */
+#define PWM_STA_FULL	0x001		/* FIFO full */
+#define PWM_STA_EMPT	0x002		/* FIFO empty */
+#define PWM_STA_WERR	0x004		/* FIFO write error */
+#define PWM_STA_RERR	0x008		/* FIFO read error */
+#define PWM_STA_GAPO(ch) (0x010 << ((ch) - 1))	/* Gap occurred */
+#define PWM_STA_BERR	0x100		/* Bus error */
+#define PWM_STA_STA(ch)	(0x200 << ((ch) - 1))	/* Channel transmitting */
+#define PWM_STA_ERRORS	0x1FC		/* Write 1 to clear */
+
+/* PWM_DMAC bits */
+#define PWM_DMAC_ENAB	0x80000000
+#define PWM_DMAC_PANIC(n) ((n) << 8)
+#define PWM_DMAC_DREQ(n) (n)
+
+/*
+ * Clock manager words for the PWM clock :
+ */
+#define	PWMCLK_CNTL	40
+#define	PWMCLK_DIV	41
+
+#define CLK_PASSWD	0x5A000000
+#define CLK_SRC_OSC	0x01		/* Oscillator source */
+#define CLK_ENAB	0x10
+#define CLK_KILL	0x20
+#define CLK_BUSY	0x80
+
+#define PWM_CLOCK_HZ	19200000.0	/* Oscillator clock source */
+#define PWM_CHANNELS	2
+#define PWM_FIFO_WORDS	16
+
+typedef enum {
+	pwm_mode_pwm = 0,		/* Spread out high steps */
+	pwm_mode_ms,			/* Mark-space */
+	pwm_mode_serial			/* Serializer */
+} pwm_mode_t;
+
+/* pwm_channel() flags */
+#define PWM_FIFO	0x01		/* Data from the FIFO (USEF) */
+#define PWM_REPEAT	0x02		/* Repeat the last word when empty */
+#define PWM_SILENCE_HIGH 0x04		/* Idle high */
+#define PWM_INVERT	0x08		/* Invert the output */
+
+typedef struct pwm_stream pwm_stream_t;
+
+int pwm_init(void);
+int pwm_clock(float freq);
+int pwm_channel(int ch,int gpio,pwm_mode_t mode,unsigned flags);
+void pwm_set(int ch,unsigned data,unsigned range);
+void pwm_start(int ch,int on);
+unsigned pwm_status(void);
+void pwm_fifo_clear(void);
+unsigned pwm_fifo_write(const unsigned *words,unsigned n);
+
+pwm_stream_t *pwm_stream_open(int dma_chan,unsigned max_words);
+int pwm_stream_play(pwm_stream_t *st,const unsigned *words,unsigned n,int loop);
+int pwm_stream_busy(pwm_stream_t *st);
+void pwm_stream_stop(pwm_stream_t *st);
+void pwm_stream_close(pwm_stream_t *st);
+const dma_mem_t *pwm_stream_mem(pwm_stream_t *st);
+
+/* The original channel 1 on GPIO 18 interface */
+int pwm_frequency(float freq);
+void pwm_ratio(unsigned n,unsigned m);
+void pwm_markspace(int on);
+void pwm_enable(int on);
+
+#endif /* PWM_IO_H */
+
+/*********************************************************************
+ * End pwm_io.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,156 @@
+/*********************************************************************
+ * rt_setup.c : Real-time setup for bit-banging threads (libgpio)
+ *********************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "rt_setup.h"
+
+/*
+ * Internal : Touch RT_STACK bytes of stack so that the pages are
+ * faulted in (and locked) before the time critical code runs.
+ */
+static void
+prefault_stack(void) {
+	volatile unsigned char stack[RT_STACK];
+	unsigned x;
+
+	for ( x=0; x<sizeof stack; x += 4096 )
+		stack[x] = 0;
+}
+
+/*
+ * Internal : Warn when cpu is not in the isolated CPU list
+ */
+static void
+check_isolated(int cpu) {
+	char buf[256], *p = buf;
+	int lo, hi, n;
+	FILE *f;
+
+	if ( !(f = fopen("/sys/devices/system/cpu/isolated","r")) )
+		return;
+	if ( !fgets(buf,sizeof buf,f) )
+		buf[0] = 0;
+	fclose(f);
+
+	while ( sscanf(p,"%d%n",&lo,&n) == 1 ) {
+		p += n;
+		hi = lo;
+		if ( *p == '-' && sscanf(++p,"%d%n",&hi,&n) == 1 )
+			p += n;
+		if ( cpu >= lo && cpu <= hi )
+			return;			/* Isolated */
+		if ( *p == ',' )
+			++p;
+	}
+	fprintf(stderr,"rt_setup: CPU %d is not isolated (boot with isolcpus=%d)\n",cpu,cpu);
+}
+
+/*********************************************************************
+ * Measure the wakeup latency of the calling thread: the time by
+ * which clock_nanosleep() overshoots an absolute period_us wakeup.
+ *********************************************************************/
+void
+rt_latency(rt_latency_t *lat,unsigned samples,unsigned period_us) {
+	struct timespec next, now;
+	double us, total = 0.0;
+	unsigned x;
+
+	lat->min_us = 1e9;
+	lat->max_us = 0.0;
+
+	clock_gettime(CLOCK_MONOTONIC,&next);
+	for ( x=0; x<samples; ++x ) {
+		next.tv_nsec += period_us * 1000;
+		while ( next.tv_nsec >= 1000000000 ) {
+			next.tv_nsec -= 1000000000;
+			++next.tv_sec;
+		}
+		while ( clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&next,0) == EINTR )
+			;
+		clock_gettime(CLOCK_MONOTONIC,&now);
+
+		us = (now.tv_sec - next.tv_sec) * 1e6 + (now.tv_nsec - next.tv_nsec) / 1e3;
+		total += us;
+		if ( us < lat->min_us )
+			lat->min_us = us;
+		if ( us > lat->max_us )
+			lat->max_us = us;
+	}
+	lat->avg_us = samples ? total / samples : 0.0;
+}
+
+/*********************************************************************
+ * Prepare the calling thread for real-time work. A cpu < 0 leaves
+ * the affinity alone and a priority <= 0 leaves the scheduling
+ * policy alone. Every step is attempted; failures are reported to
+ * stderr and make the return value -1.
+ *********************************************************************/
+int
+rt_setup(int cpu,int priority) {
+	struct sched_param param;
+	rt_latency_t lat;
+	cpu_set_t cpus;
+	int rc = 0, err;
+
+	if ( cpu >= 0 ) {
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu,&cpus);
+		err = pthread_setaffinity_np(pthread_self(),sizeof cpus,&cpus);
+		if ( err ) {
+			fprintf(stderr,"%s: rt_setup pinning to CPU %d\n",strerror(err),cpu);
+			rc = -1;
+		} else	check_isolated(cpu);
+	}
+
+	if ( priority > 0 ) {
+		memset(&param,0,sizeof param);
+		param.sched_priority = priority;
+		err = pthread_setschedparam(pthread_self(),SCHED_FIFO,&param);
+		if ( err ) {
+			fprintf(stderr,"%s: rt_setup SCHED_FIFO priority %d\n",strerror(err),priority);
+			rc = -1;
+		}
+	}
+
+	if ( mlockall(MCL_CURRENT|MCL_FUTURE) ) {
+		perror("rt_setup mlockall()");
+		rc = -1;
+	}
+	prefault_stack();
+
+	rt_latency(&lat,200,500);
+	fprintf(stderr,"rt_setup: CPU %d, SCHED_FIFO %d: wakeup latency "
+		"min %.1f avg %.1f max %.1f us\n",
+		cpu,priority,lat.min_us,lat.avg_us,lat.max_us);
+	return rc;
+}
+
+/*********************************************************************
+ * Handle a tool's -R option: "cpu" or "cpu,priority"
+ *********************************************************************/
+int
+rt_optarg(const char *arg) {
+	int cpu = -1, priority = RT_PRIORITY;
+
+	if ( sscanf(arg,"%d,%d",&cpu,&priority) < 1 ) {
+		fprintf(stderr,"Bad -R argument '%s' (use cpu[,priority])\n",arg);
+		return -1;
+	}
+	return rt_setup(cpu,priority);
+}
+
+/*********************************************************************
+ * End rt_setup.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,36 @@
+/*********************************************************************
+ * rt_setup.h : Real-time setup for bit-banging threads (libgpio)
+ *
+ * rt_setup() prepares the calling thread for busy-wait protocols:
+ * it pins the thread to one CPU, switches it to SCHED_FIFO, locks
+ * all process memory, pre-faults the thread's stack and then
+ * measures the wakeup latency it achieved. Best results come from a
+ * core kept free of other work with the isolcpus= boot parameter.
+ *
+ * Tools accept "-R cpu[,priority]" and hand the argument to
+ * rt_optarg().
+ *********************************************************************/
+
+#ifndef RT_SETUP_H
+#define RT_SETUP_H
+
+#define RT_PRIORITY	80		/* Default SCHED_FIFO priority */
+#define RT_STACK	(256*1024)	/* Stack bytes to pre-fault */
+
+typedef struct {
+	double	min_us;			/* Smallest wakeup latency */
+	double	avg_us;			/* Average wakeup latency */
+	double	max_us;			/* Worst wakeup latency */
+} rt_latency_t;
+
+int rt_setup(int cpu,int priority);	/* Returns 0, or -1 if any step failed */
+int rt_optarg(const char *arg);		/* Parse "cpu[,priority]" and rt_setup() */
+void rt_latency(rt_latency_t *lat,unsigned samples,unsigned period_us);
+
+#endif /* RT_SETUP_H */
+
+/*********************************************************************
+ * End rt_setup.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,166 @@
+/*********************************************************************
+ * uinput_dev.c : Synthesized input devices through /dev/uinput
+ *
+ * Factored out of nunchuk.c, so that other projects (irdecode) can
+ * post key events too.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uinput.h>
+
+#include "uinput_dev.h"
+
+/*
+ * Open a uinput node, creating a device named name that sends
+ * the nkeys keys[] and relative movement if rel. Returns the
+ * open fd, or -1 (reported) when /dev/uinput cannot be opened.
+ */
+int
+uinput_open(const char *name,const unsigned *keys,unsigned nkeys,int rel) {
+	struct uinput_user_dev uinp;
+	unsigned x;
+	int fd, rc;
+
+	fd = open("/dev/uinput",O_WRONLY|O_NONBLOCK);
+	if ( fd < 0 ) {
+		perror("Opening /dev/uinput");
+		return -1;
+	}
+
+	rc = ioctl(fd,UI_SET_EVBIT,EV_KEY);
+	assert(!rc);
+
+	if ( rel ) {
+		rc = ioctl(fd,UI_SET_EVBIT,EV_REL);
+		assert(!rc);
+		rc = ioctl(fd,UI_SET_RELBIT,REL_X);
+		assert(!rc);
+		rc = ioctl(fd,UI_SET_RELBIT,REL_Y);
+		assert(!rc);
+	}
+
+	for ( x=0; x<nkeys; ++x ) {
+		rc = ioctl(fd,UI_SET_KEYBIT,keys[x]);
+		assert(!rc);
+	}
+
+	memset(&uinp,0,sizeof uinp);
+	strncpy(uinp.name,name,UINPUT_MAX_NAME_SIZE-1);
+	uinp.id.bustype = BUS_USB;
+	uinp.id.vendor  = 0x1;
+	uinp.id.product = 0x1;
+	uinp.id.version = 1;
+
+	rc = write(fd,&uinp,sizeof(uinp));
+	assert(rc == sizeof(uinp));
+
+	rc = ioctl(fd,UI_DEV_CREATE);
+	assert(!rc);
+	return fd;
+}
+
+/*
+ * Post one key event: value 1=down, 0=up, 2=autorepeat
+ */
+void
+uinput_key(int fd,unsigned key,int value) {
+	struct input_event ev;
+	int rc;
+
+	memset(&ev,0,sizeof(ev));
+	ev.type = EV_KEY;
+	ev.code = key;
+	ev.value = value;
+
+	rc = write(fd,&ev,sizeof(ev));
+	assert(rc == sizeof(ev));
+}
+
+/*
+ * Post keystroke down and keystroke up events:
+ */
+void
+uinput_postkey(int fd,unsigned key) {
+	uinput_key(fd,key,1);		/* Key down */
+	uinput_key(fd,key,0);		/* Key up */
+}	
+
+/*
+ * Post a synchronization point :
+ */
+void
+uinput_syn(int fd) {
+	struct input_event ev;
+	int rc;
+
+	memset(&ev,0,sizeof(ev));
+	ev.type = EV_SYN;
+	ev.code = SYN_REPORT;
+	ev.value = 0;
+	rc = write(fd,&ev,sizeof(ev));
+	assert(rc == sizeof(ev));
+}
+
+/*
+ * Synthesize a button click:
+ *	up_down		1=up, 0=down
+ *	buttons		1=Left, 2=Middle, 4=Right
+ */
+void
+uinput_click(int fd,int up_down,int buttons) {
+	static unsigned codes[] = { BTN_LEFT, BTN_MIDDLE, BTN_RIGHT };
+	int x;
+
+	/*
+	 * Button down or up events :
+	 */
+	for ( x=0; x < 3; ++x )
+		if ( buttons & (1 << x) )	/* Button 0, 1 or 2 */
+			uinput_key(fd,codes[x],up_down);
+}
+
+/*
+ * Synthesize relative mouse movement :
+ */
+void
+uinput_movement(int fd,int x,int y) {
+	struct input_event ev;
+	int rc;
+
+	memset(&ev,0,sizeof(ev));
+	ev.type = EV_REL;
+	ev.code = REL_X;
+	ev.value = x;
+
+	rc = write(fd,&ev,sizeof(ev));
+	assert(rc == sizeof(ev));
+
+	ev.code = REL_Y;
+	ev.value = y;
+	rc = write(fd,&ev,sizeof(ev));
+	assert(rc == sizeof(ev));
+}	
+
+/*
+ * Close uinput device :
+ */
+void
+uinput_close(int fd) {
+	int rc;
+
+	rc = ioctl(fd,UI_DEV_DESTROY);
+	assert(!rc);
+	close(fd);
+}
+
+/*********************************************************************
+ * End uinput_dev.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,28 @@
+/*********************************************************************
+ * uinput_dev.h : Synthesized input devices through /dev/uinput
+ *
+ * uinput_open() creates an input device that can send the listed
+ * keys (KEY_* and BTN_* of <linux/input.h>) and, if rel is true,
+ * relative X/Y movement. Events written are seen by the console,
+ * X and evdev readers like any keyboard or mouse, once a
+ * uinput_syn() ends the group.
+ *********************************************************************/
+
+#ifndef UINPUT_DEV_H
+#define UINPUT_DEV_H
+
+int uinput_open(const char *name,const unsigned *keys,unsigned nkeys,int rel);
+void uinput_key(int fd,unsigned key,int value);
+void uinput_postkey(int fd,unsigned key);
+void uinput_syn(int fd);
+void uinput_click(int fd,int up_down,int buttons);
+void uinput_movement(int fd,int x,int y);
+void uinput_close(int fd);
+
+#endif /* UINPUT_DEV_H */
+
+/*********************************************************************
+ * End uinput_dev.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,83 @@
+/*********************************************************************
+ * user_file.c : Files named by the user of a setuid tool (libgpio)
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include "user_file.h"
+
+/*********************************************************************
+ * Take the real user's rights. Failing to is fatal.
+ *********************************************************************/
+uid_t
+user_begin(void) {
+	uid_t euid = geteuid();
+
+	if ( seteuid(getuid()) ) {
+		perror("seteuid(real uid)");
+		exit(2);
+	}
+	return euid;
+}
+
+/*********************************************************************
+ * Return to the effective uid that user_begin() returned
+ *********************************************************************/
+void
+user_end(uid_t euid) {
+	int e = errno;
+
+	if ( seteuid(euid) ) {
+		perror("seteuid()");
+		exit(2);
+	}
+	errno = e;
+}
+
+/*********************************************************************
+ * Open path as the real user. Returns 0 with errno set on failure.
+ *********************************************************************/
+FILE *
+user_fopen(const char *path,const char *mode) {
+	int flags, fd;
+	uid_t euid;
+	FILE *f;
+
+	switch ( mode[0] ) {
+	case 'r' :
+		flags = strchr(mode,'+') ? O_RDWR : O_RDONLY;
+		break;
+	case 'w' :
+		flags = (strchr(mode,'+') ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC | O_NOFOLLOW;
+		break;
+	case 'a' :
+		flags = (strchr(mode,'+') ? O_RDWR : O_WRONLY) | O_CREAT | O_APPEND | O_NOFOLLOW;
+		break;
+	default :
+		errno = EINVAL;
+		return 0;
+	}
+
+	euid = user_begin();
+	fd = open(path,flags,0644);
+	user_end(euid);
+
+	if ( fd < 0 )
+		return 0;
+	if ( !(f = fdopen(fd,mode)) ) {
+		close(fd);
+		return 0;
+	}
+	return f;
+}
+
+/*********************************************************************
+ * End user_file.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
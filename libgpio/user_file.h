@@ -0,0 +1,28 @@
+/*********************************************************************
+ * user_file.h : Files named by the user of a setuid tool (libgpio)
+ *
+ * The GPIO tools are installed setuid root, but a path given on the
+ * command line must only reach what the invoking user could reach
+ * without them. user_fopen() opens it with the effective uid set to
+ * the real uid, and never follows a symlink when creating. Other
+ * operations on user named objects go between user_begin() and
+ * user_end(). When not setuid, these change nothing.
+ *********************************************************************/
+
+#ifndef USER_FILE_H
+#define USER_FILE_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+uid_t user_begin(void);			/* Returns the euid to restore */
+void user_end(uid_t euid);
+FILE *user_fopen(const char *path,const char *mode);	/* fopen() modes */
+
+#endif /* USER_FILE_H */
+
+/*********************************************************************
+ * End user_file.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
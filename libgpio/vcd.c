@@ -0,0 +1,90 @@
+/*********************************************************************
+ * vcd.c : Value Change Dump (VCD) writer for GPIO waveforms
+ *
+ * The output loads into GTKWave and similar viewers. Times are
+ * written in nanoseconds relative to the first sample.
+ *********************************************************************/
+
+#include <stdio.h>
+
+#include "vcd.h"
+
+/*
+ * Internal : VCD identifier for a GPIO (printable, starting at '!')
+ */
+static const char *
+vcd_id(int gpio,char *buf) {
+	buf[0] = '!' + gpio;
+	buf[1] = 0;
+	return buf;
+}
+
+/*********************************************************************
+ * Write the VCD header and wire declarations
+ *********************************************************************/
+void
+vcd_begin(vcd_t *vcd,FILE *f,const char *module,unsigned long long mask) {
+	char id[2];
+	int gpio;
+
+	vcd->f = f;
+	vcd->mask = mask;
+	vcd->last = 0;
+	vcd->t0 = 0;
+	vcd->started = 0;
+
+	fputs("$version libgpio $end\n$timescale 1ns $end\n",f);
+	fprintf(f,"$scope module %s $end\n",module);
+	for ( gpio=0; gpio<64; ++gpio )
+		if ( mask & 1ULL << gpio )
+			fprintf(f,"$var wire 1 %s gpio%d $end\n",vcd_id(gpio,id),gpio);
+	fputs("$upscope $end\n$enddefinitions $end\n",f);
+}
+
+/*********************************************************************
+ * Record the levels at time ns, writing only what changed
+ *********************************************************************/
+void
+vcd_sample(vcd_t *vcd,unsigned long long ns,unsigned long long levels) {
+	unsigned long long changed;
+	char id[2];
+	int gpio;
+
+	levels &= vcd->mask;
+	if ( !vcd->started ) {
+		vcd->t0 = ns;
+		changed = vcd->mask;			/* Dump everything */
+		fputs("#0\n$dumpvars\n",vcd->f);
+	} else	{
+		if ( levels == vcd->last )
+			return;
+		changed = levels ^ vcd->last;
+		fprintf(vcd->f,"#%llu\n",ns - vcd->t0);
+	}
+
+	for ( gpio=0; gpio<64; ++gpio )
+		if ( changed & 1ULL << gpio )
+			fprintf(vcd->f,"%d%s\n",levels & 1ULL << gpio ? 1 : 0,vcd_id(gpio,id));
+
+	if ( !vcd->started ) {
+		fputs("$end\n",vcd->f);
+		vcd->started = 1;
+	}
+	vcd->last = levels;
+}
+
+/*********************************************************************
+ * Mark the end time of the dump
+ *********************************************************************/
+void
+vcd_end(vcd_t *vcd,unsigned long long ns) {
+	if ( vcd->started )
+		fprintf(vcd->f,"#%llu\n",ns - vcd->t0);
+	fflush(vcd->f);
+}
+
+/*********************************************************************
+ * End vcd.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
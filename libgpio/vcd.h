@@ -0,0 +1,32 @@
+/*********************************************************************
+ * vcd.h : Value Change Dump (VCD) writer for GPIO waveforms
+ *
+ * Each GPIO selected in the 64 bit mask becomes a one bit wire
+ * named gpioN. Feed vcd_sample() the levels of all GPIOs (bit n is
+ * GPIO n) at increasing times; only changes are written.
+ *********************************************************************/
+
+#ifndef VCD_H
+#define VCD_H
+
+#include <stdio.h>
+
+typedef struct {
+	FILE			*f;	/* Output stream */
+	unsigned long long	mask;	/* GPIOs being dumped */
+	unsigned long long	last;	/* Last levels written */
+	unsigned long long	t0;	/* Time of first sample (ns) */
+	int			started;/* True after first sample */
+} vcd_t;
+
+void vcd_begin(vcd_t *vcd,FILE *f,const char *module,unsigned long long mask);
+void vcd_sample(vcd_t *vcd,unsigned long long ns,unsigned long long levels);
+void vcd_end(vcd_t *vcd,unsigned long long ns);
+
+#endif /* VCD_H */
+
+/*********************************************************************
+ * End vcd.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
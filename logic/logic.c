@@ -0,0 +1,251 @@
+/*********************************************************************
+ * logic.c : Capture GPIO levels like a logic analyzer
+ *
+ * ./logic [-m mask] [-s secs] [-r runs] [-n samples] [-R cpu[,prio]] -o file.cap
+ *
+ * GPLEV0 (and GPLEV1, when the mask selects any of GPIOs 32-53) is
+ * sampled in a tight loop into a preallocated ring of
+ * chunks. Unchanged samples are run length encoded as they are
+ * taken, and each chunk is timestamped at its start and end. A
+ * writer thread streams the completed chunks to the file, so the
+ * sampling loop never waits on I/O. Convert with logic2vcd.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
+#include "user_file.h"			/* user_fopen() (libgpio) */
+#include "logic.h"			/* Capture file format */
+
+#define N_CHUNKS	64		/* Chunks in the ring */
+
+typedef struct {
+	logic_chunk_t	hdr;		/* Chunk header (as written) */
+	logic_run_t	*runs;		/* Run length encoded samples */
+} chunk_t;
+
+static chunk_t ring[N_CHUNKS];		/* Preallocated chunk ring */
+static unsigned head = 0;		/* Chunks filled (producer) */
+static unsigned tail = 0;		/* Chunks written (consumer) */
+static int done = 0;			/* Capture has ended */
+static volatile int is_signaled = 0;	/* Exit program if signaled */
+
+static FILE *cap_file = 0;		/* Capture file */
+static unsigned max_runs = 4096;	/* Runs per chunk */
+static unsigned max_samples = 1 << 20;	/* Samples per chunk */
+
+/*
+ * Signal handler to stop the capture :
+ */
+static void
+sigint_handler(int signo) {
+	is_signaled = 1;
+}
+
+/*
+ * Return CLOCK_MONOTONIC_RAW in nanoseconds :
+ */
+static inline unsigned long long
+ns_raw(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW,&ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Writer thread: stream completed chunks to the file
+ */
+static void *
+writer(void *arg) {
+	chunk_t *chunk;
+	unsigned h;
+	int fin;
+
+	for (;;) {
+		fin = __atomic_load_n(&done,__ATOMIC_ACQUIRE);	/* Before head */
+		h = __atomic_load_n(&head,__ATOMIC_ACQUIRE);
+		if ( tail == h ) {
+			if ( fin )
+				break;
+			usleep(1000);
+			continue;
+		}
+
+		chunk = &ring[tail % N_CHUNKS];
+		if ( fwrite(&chunk->hdr,sizeof chunk->hdr,1,cap_file) != 1
+		  || fwrite(chunk->runs,sizeof *chunk->runs,chunk->hdr.n_runs,cap_file) != chunk->hdr.n_runs ) {
+			perror("Writing capture file");
+			exit(1);
+		}
+		__atomic_store_n(&tail,tail+1,__ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+/*
+ * Sample the masked levels, loading GPLEV1 only when it is needed :
+ */
+static inline unsigned long long
+sample(unsigned long long mask) {
+	if ( mask >> 32 )
+		return gpio_read_all64() & mask;
+	return gpio_read_all() & (unsigned)mask;
+}
+
+/*
+ * Fill one chunk, sampling as fast as the loop allows :
+ */
+static void
+sample_chunk(chunk_t *chunk,unsigned long long mask) {
+	logic_run_t *run = chunk->runs;
+	logic_run_t *end_run = chunk->runs + max_runs;
+	unsigned long long v, last;
+	unsigned samples;
+
+	chunk->hdr.t0_ns = ns_raw();
+	last = sample(mask);
+	run->lo = last;
+	run->hi = last >> 32;
+	run->count = 1;
+
+	for ( samples=1; samples < max_samples; ++samples ) {
+		v = sample(mask);
+		if ( v == last ) {
+			++run->count;
+		} else	{
+			if ( ++run >= end_run ) {
+				--run;			/* Chunk full: resample */
+				break;
+			}
+			run->lo = last = v;
+			run->hi = v >> 32;
+			run->count = 1;
+		}
+	}
+
+	chunk->hdr.t1_ns = ns_raw();
+	chunk->hdr.samples = samples;
+	chunk->hdr.n_runs = run - chunk->runs + 1;
+}
+
+/*
+ * Main program :
+ */
+int
+main(int argc,char **argv) {
+	const char *path = 0;
+	unsigned long long mask = 0xFFFFFFFF;
+	double secs = 10.0;
+	unsigned long long t_start, t_end, total = 0;
+	unsigned long stalls = 0;
+	logic_hdr_t hdr;
+	pthread_t tid;
+	const char *rt_arg = 0;
+	int optch, x, rc;
+
+	while ( (optch = getopt(argc,argv,"m:s:r:n:o:R:h")) != EOF )
+		switch ( optch ) {
+		case 'm' :
+			mask = strtoull(optarg,0,0);
+			break;
+		case 's' :
+			secs = atof(optarg);
+			break;
+		case 'r' :
+			max_runs = strtoul(optarg,0,0);
+			break;
+		case 'n' :
+			max_samples = strtoul(optarg,0,0);
+			break;
+		case 'o' :
+			path = optarg;
+			break;
+		case 'R' :
+			rt_arg = optarg;
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,
+				"Usage: %s [-m mask] [-s secs] [-r runs] [-n samples] [-R cpu[,prio]] -o file\n",argv[0]);
+			fputs("where:\n"
+				"  -m mask\tGPIOs 0-53 to capture (0xFFFFFFFF)\n"
+				"  -s secs\tcapture time (10 seconds, ^C stops early)\n"
+				"  -r runs\truns per chunk (4096)\n"
+				"  -n samples\tmaximum samples per chunk (1048576)\n"
+				"  -R cpu[,prio]\treal-time CPU and priority for sampling\n"
+				"  -o file\tcapture file to write\n",
+				stderr);
+			exit(1);
+		}
+
+	if ( !path || max_runs < 1 || max_samples < 1 )
+		goto usage;
+	mask &= (1ULL << GPIO_COUNT) - 1;	/* GPIOs 0-53 only */
+
+	if ( !(cap_file = user_fopen(path,"wb")) ) {	/* Not as root */
+		fprintf(stderr,"%s: opening %s for write\n",strerror(errno),path);
+		return 1;
+	}
+
+	for ( x=0; x<N_CHUNKS; ++x ) {
+		ring[x].runs = malloc(max_runs * sizeof *ring[x].runs);
+		assert(ring[x].runs);
+		memset(ring[x].runs,0,max_runs * sizeof *ring[x].runs); /* Pre-fault */
+	}
+
+	memset(&hdr,0,sizeof hdr);
+	strncpy(hdr.magic,LOGIC_MAGIC,sizeof hdr.magic);
+	hdr.mask_lo = mask;
+	hdr.mask_hi = mask >> 32;
+	fwrite(&hdr,sizeof hdr,1,cap_file);
+
+	gpio_init();				/* Initialize GPIO access */
+	signal(SIGINT,sigint_handler);		/* Trap on SIGINT */
+
+	rc = pthread_create(&tid,0,writer,0);	/* Writer keeps normal policy */
+	assert(!rc);
+
+	if ( rt_arg )
+		rt_optarg(rt_arg);		/* Real-time sampling thread */
+
+	t_start = ns_raw();
+	t_end = t_start + (unsigned long long)(secs * 1e9);
+
+	while ( !is_signaled && ns_raw() < t_end ) {
+		/* Wait for the writer if the ring is full */
+		while ( head - __atomic_load_n(&tail,__ATOMIC_ACQUIRE) >= N_CHUNKS ) {
+			++stalls;
+			usleep(100);		/* Writer may share our CPU */
+		}
+
+		sample_chunk(&ring[head % N_CHUNKS],mask);
+		total += ring[head % N_CHUNKS].hdr.samples;
+		__atomic_store_n(&head,head+1,__ATOMIC_RELEASE);
+	}
+
+	t_end = ns_raw();
+	__atomic_store_n(&done,1,__ATOMIC_RELEASE);
+	pthread_join(tid,0);
+	fclose(cap_file);
+	gpio_fini();
+
+	printf("%llu samples in %.3f s (%.1f Msamples/s), %u chunks, %lu stalls\n",
+		total,(t_end - t_start) / 1e9,total * 1e3 / (t_end - t_start),head,stalls);
+	return 0;
+}
+
+/*********************************************************************
+ * End logic.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -0,0 +1,37 @@
+/*********************************************************************
+ * logic.h : Capture file format written by logic, read by logic2vcd
+ *
+ * The file is a logic_hdr_t followed by chunks, in host byte order.
+ * Each chunk is a logic_chunk_t followed by n_runs logic_run_t. A run
+ * is count consecutive identical samples of the masked GPIO levels.
+ * Only the chunk boundaries are timestamped (CLOCK_MONOTONIC_RAW);
+ * the samples within a chunk are taken at an even rate, so sample
+ * k of n lies at t0_ns + (t1_ns - t0_ns) * k / n.
+ *********************************************************************/
+
+#define LOGIC_MAGIC	"GPCAP1"
+
+typedef struct {
+	char		magic[8];	/* LOGIC_MAGIC */
+	unsigned	mask_lo;	/* GPIOs 0-31 captured */
+	unsigned	mask_hi;	/* GPIOs 32-53 captured */
+} logic_hdr_t;
+
+typedef struct {
+	unsigned long long t0_ns;	/* Time of first sample */
+	unsigned long long t1_ns;	/* Time after last sample */
+	unsigned	samples;	/* Samples in this chunk */
+	unsigned	n_runs;		/* logic_run_t that follow */
+} logic_chunk_t;
+
+typedef struct {
+	unsigned	lo;		/* GPLEV0 & mask_lo */
+	unsigned	hi;		/* GPLEV1 & mask_hi */
+	unsigned	count;		/* Repeat count */
+} logic_run_t;
+
+/*********************************************************************
+ * End logic.h - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
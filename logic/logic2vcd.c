@@ -0,0 +1,67 @@
+/*********************************************************************
+ * logic2vcd.c : Convert a logic capture file to VCD
+ *
+ * ./logic2vcd file.cap >file.vcd
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "vcd.h"			/* VCD writer (libgpio) */
+#include "logic.h"			/* Capture file format */
+
+int
+main(int argc,char **argv) {
+	logic_hdr_t hdr;
+	logic_chunk_t chunk;
+	logic_run_t run;
+	vcd_t vcd;
+	unsigned long long t = 0, samples = 0;
+	unsigned r, k;
+	FILE *f;
+
+	if ( argc != 2 ) {
+		fprintf(stderr,"Usage: %s file.cap >file.vcd\n",argv[0]);
+		return 1;
+	}
+
+	if ( !(f = fopen(argv[1],"rb")) ) {
+		fprintf(stderr,"%s: opening %s\n",strerror(errno),argv[1]);
+		return 1;
+	}
+
+	if ( fread(&hdr,sizeof hdr,1,f) != 1 || strncmp(hdr.magic,LOGIC_MAGIC,sizeof hdr.magic) ) {
+		fprintf(stderr,"%s: not a logic capture file\n",argv[1]);
+		return 1;
+	}
+
+	vcd_begin(&vcd,stdout,"logic",(unsigned long long)hdr.mask_hi << 32 | hdr.mask_lo);
+
+	while ( fread(&chunk,sizeof chunk,1,f) == 1 ) {
+		for ( r=k=0; r<chunk.n_runs; ++r ) {
+			if ( fread(&run,sizeof run,1,f) != 1 ) {
+				fprintf(stderr,"%s: truncated chunk\n",argv[1]);
+				return 1;
+			}
+			/* Time of sample k, interpolated within the chunk */
+			t = chunk.t0_ns + (chunk.t1_ns - chunk.t0_ns) * k / chunk.samples;
+			vcd_sample(&vcd,t,(unsigned long long)run.hi << 32 | run.lo);
+			k += run.count;
+		}
+		samples += chunk.samples;
+		t = chunk.t1_ns;
+	}
+
+	vcd_end(&vcd,t);
+	fclose(f);
+	fprintf(stderr,"%llu samples converted.\n",samples);
+	return 0;
+}
+
+/*********************************************************************
+ * End logic2vcd.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -26,9 +26,9 @@
 #include <signal.h>
 #include <assert.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
 #include <linux/i2c-dev.h>
 
+#include "gpio_line.h"			/* Kernel GPIO lines (libgpio) */
 #include "i2c_funcs.c"			/* I2C routines */
 
 /* Change to i2c-0 if using early Raspberry Pi */
@@ -55,8 +55,6 @@ static unsigned gpio_addr = 0x20;	/* MCP23017 I2C Address */
 static const int gpio_inta = 17;	/* GPIO pin for INTA connection */
 static int is_signaled = 0;		/* Exit program if signaled */
 
-#include "sysgpio.c"
-
 /*
  * Signal handler to quit the program :
  */
@@ -172,21 +170,24 @@ post_outputs(void) {
  */
 int
 main(int argc,char **argv) {
+	gpio_line_t *inta;
+	gpio_edge_t edges[8];
 	int int_flags, v;
-	int fd;
 
 	signal(SIGINT,sigint_handler);		/* Trap on SIGINT */
 
 	i2c_init(node);				/* Initialize for I2C */
 	mcp23017_init();			/* Configure MCP23017 @ 20 */
 
-	fd = gpio_open_edge(gpio_inta);		/* Configure INTA pin */
+	inta = gpio_line_input(gpio_inta,GPIO_EV_FALLING,0); /* INTA pin */
+	if ( !inta )
+		return 1;
 
 	puts("Monitoring for MCP23017 input changes:\n");
 	post_outputs();				/* Copy inputs to outputs */
 
 	do	{
-		gpio_poll(fd);			/* Pause until an interrupt */
+		gpio_line_wait(inta,edges,8,-1); /* Pause until an interrupt */
 
 		int_flags = mcp23017_interrupts();
 		if ( int_flags ) {
@@ -200,8 +201,7 @@ main(int argc,char **argv) {
 	fputc('\n',stdout);
 
 	i2c_close();				/* Close I2C driver */
-	close(fd);				/* Close gpio17/value */
-	gpio_close(gpio_inta);			/* Unexport gpio17 */
+	gpio_line_close(inta);			/* Release gpio17 */
 	return 0;
 }
 
@@ -14,9 +14,9 @@
 #include <sys/ioctl.h>
 #include <linux/i2c-dev.h>
 #include <linux/input.h>
-#include <linux/uinput.h>
 
 #include "timed_wait.c"
+#include "uinput_dev.h"		/* uinput routines (libgpio) */
 
 static int is_signaled = 0;	/* Exit program if signaled */
 static int i2c_fd = -1;		/* Open /dev/i2c-1 device */
@@ -186,154 +186,6 @@ i2c_close(void) {
 	i2c_fd = -1;
 }
 
-/*
- * Open a uinput node:
- */
-static int
-uinput_open(void) {
-	int fd;
-	struct uinput_user_dev uinp;
-	int rc;
-
-	fd = open("/dev/uinput",O_WRONLY|O_NONBLOCK);
-	if ( fd < 0 ) {
-		perror("Opening /dev/uinput");
-		exit(1);
-	}
-
-	rc = ioctl(fd,UI_SET_EVBIT,EV_KEY);
-	assert(!rc);
-	rc = ioctl(fd,UI_SET_EVBIT,EV_REL);
-	assert(!rc);
-
-	rc = ioctl(fd,UI_SET_RELBIT,REL_X);
-	assert(!rc);
-	rc = ioctl(fd,UI_SET_RELBIT,REL_Y);
-	assert(!rc);
-
-	rc = ioctl(fd,UI_SET_KEYBIT,KEY_ESC);
-	assert(!rc);
-
-	ioctl(fd,UI_SET_KEYBIT,BTN_MOUSE);
-	ioctl(fd,UI_SET_KEYBIT,BTN_TOUCH);
-	ioctl(fd,UI_SET_KEYBIT,BTN_MOUSE);
-	ioctl(fd,UI_SET_KEYBIT,BTN_LEFT);
-	ioctl(fd,UI_SET_KEYBIT,BTN_MIDDLE);
-	ioctl(fd,UI_SET_KEYBIT,BTN_RIGHT);
-
-	memset(&uinp,0,sizeof uinp);
-	strncpy(uinp.name,"nunchuk",UINPUT_MAX_NAME_SIZE);
-	uinp.id.bustype = BUS_USB;
-	uinp.id.vendor  = 0x1;
-	uinp.id.product = 0x1;
-	uinp.id.version = 1;
-
-	rc = write(fd,&uinp,sizeof(uinp));
-	assert(rc == sizeof(uinp));
-
-	rc = ioctl(fd,UI_DEV_CREATE);
-	assert(!rc);
-	return fd;
-}
-
-/*
- * Post keystroke down and keystroke up events:
- * (unused here but available for your own experiments)
- */
-static void
-uinput_postkey(int fd,unsigned key) {
-	struct input_event ev;
-	int rc;
-
-	memset(&ev,0,sizeof(ev));
-	ev.type = EV_KEY;
-	ev.code = key;
-	ev.value = 1;			/* Key down */
-
-	rc = write(fd,&ev,sizeof(ev));
-	assert(rc == sizeof(ev));
-
-	ev.value = 0;			/* Key up */
-	rc = write(fd,&ev,sizeof(ev));
-	assert(rc == sizeof(ev));
-}	
-
-/*
- * Post a synchronization point :
- */
-static void
-uinput_syn(int fd) {
-	struct input_event ev;
-	int rc;
-
-	memset(&ev,0,sizeof(ev));
-	ev.type = EV_SYN;
-	ev.code = SYN_REPORT;
-	ev.value = 0;
-	rc = write(fd,&ev,sizeof(ev));
-	assert(rc == sizeof(ev));
-}
-
-/*
- * Synthesize a button click:
- *	up_down		1=up, 0=down
- *	buttons		1=Left, 2=Middle, 4=Right
- */
-static void
-uinput_click(int fd,int up_down,int buttons) {
-	static unsigned codes[] = { BTN_LEFT, BTN_MIDDLE, BTN_RIGHT };
-	struct input_event ev;
-	int x;
-
-	memset(&ev,0,sizeof(ev));
-
-	/*
-	 * Button down or up events :
-	 */
-	for ( x=0; x < 3; ++x ) {
-		ev.type = EV_KEY;
-		ev.value = up_down;		/* Button Up or down */
-		if ( buttons & (1 << x) ) {	/* Button 0, 1 or 2 */
-			ev.code = codes[x];
-			write(fd,&ev,sizeof(ev));
-		}
-	}
-}
-
-/*
- * Synthesize relative mouse movement :
- */
-static void
-uinput_movement(int fd,int x,int y) {
-	struct input_event ev;
-	int rc;
-
-	memset(&ev,0,sizeof(ev));
-	ev.type = EV_REL;
-	ev.code = REL_X;
-	ev.value = x;
-
-	rc = write(fd,&ev,sizeof(ev));
-	assert(rc == sizeof(ev));
-
-	ev.code = REL_Y;
-	ev.value = y;
-	rc = write(fd,&ev,sizeof(ev));
-	assert(rc == sizeof(ev));
-}	
-
-/*
- * Close uinput device :
- */
-static void
-uinput_close(int fd) {
-	int rc;
-
-	rc = ioctl(fd,UI_DEV_DESTROY);
-	assert(!rc);
-	close(fd);
-}
-
 /*
  * Signal handler to quit the program :
  */
@@ -370,17 +222,20 @@ main(int argc,char **argv) {
 	int fd, need_sync, init = 3;
 	int rel_x=0, rel_y = 0;
 	nunchuk_t data0, data, last;
+	static const unsigned keys[] = {
+		KEY_ESC, BTN_MOUSE, BTN_TOUCH, BTN_LEFT, BTN_MIDDLE, BTN_RIGHT
+	};
 
 	if ( argc > 1 && !strcmp(argv[1],"-d") )
 		f_debug = 1;			/* Enable debug messages */
 
-	(void)uinput_postkey;			/* Suppress compiler warning about unused */
-
 	i2c_init("/dev/i2c-1");			/* Open I2C controller */
 	nunchuk_init();				/* Turn off encryption */
 
 	signal(SIGINT,sigint_handler);		/* Trap on SIGINT */
-	fd = uinput_open();			/* Open /dev/uinput */
+	fd = uinput_open("nunchuk",keys,sizeof keys / sizeof keys[0],1);
+	if ( fd < 0 )
+		exit(1);
 
 	while ( !is_signaled ) {
 		if ( nunchuk_read(&data) < 0 )
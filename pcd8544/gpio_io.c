@@ -1 +0,0 @@
-../bipolar/gpio_io.c
\ No newline at end of file
@@ -15,16 +15,20 @@
 #include <pthread.h>
 #include <assert.h>
 
-#include "gpio_io.c"			/* GPIO routines */
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
+#include "gpio_time.h"			/* gpio_delay_ns() (libgpio) */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
 
 /*
  * GPIO definitions :
  */
-static const int lcd_ce 	= 25;	/* LCD Chip Enable GPIO */
-static const int lcd_res	= 23;	/* LCD /Reset GPIO */
-static const int lcd_d_c	= 17;	/* LCD Data/Command GPIO */
-static const int lcd_sdin	= 27;	/* LCD Serial Data In GPIO */
-static const int lcd_sclk	= 22;	/* LCD Serial Clock GPIO */
+GPIO_PIN(lcd_ce,25);			/* LCD Chip Enable GPIO */
+GPIO_PIN(lcd_res,23);			/* LCD /Reset GPIO */
+GPIO_PIN(lcd_d_c,17);			/* LCD Data/Command GPIO */
+GPIO_PIN(lcd_sdin,27);			/* LCD Serial Data In GPIO */
+GPIO_PIN(lcd_sclk,22);			/* LCD Serial Clock GPIO */
+
+#define LCD_RESET_NS	1000		/* /RES pulse and recovery (min 100ns) */
 
 /*
  * Application Routines:
@@ -264,15 +268,16 @@ lcd(Enable en) {
 	}		
 
 	if ( cs ) {				/* Chip select? */
-		gpio_write(lcd_d_c,data);	/* Data or /command mode */
-		gpio_write(lcd_ce,0);		/* Chip enable (active low) */
-		gpio_write(lcd_sclk,0);		/* Set clock to low level */
-		gpio_write(lcd_sdin,0);		/* Initially data to low for now */
+		/*
+		 * Data or /command mode is set first (if high), then
+		 * chip enable (active low), clock and data in go low
+		 * together with a single clear.
+		 */
+		gpio_write_mask(data ? 1 << lcd_d_c : 0,
+			1 << lcd_d_c | 1 << lcd_ce | 1 << lcd_sclk | 1 << lcd_sdin);
 	} else	{				/* Chip is being unselected */
-		gpio_write(lcd_ce,1);		/* Disable chip enable */
-		gpio_write(lcd_sclk,1);		/* Return sclk to high when unselected */
-		gpio_write(lcd_d_c,1);		/* Ditto for data/command */
-		gpio_write(lcd_sdin,1);		/* Ditto for data in */
+		/* Disable chip enable, return sclk, d/c and sdin high */
+		gpio_set_mask(1 << lcd_ce | 1 << lcd_sclk | 1 << lcd_d_c | 1 << lcd_sdin);
 	}
 }
 
@@ -281,9 +286,9 @@ lcd(Enable en) {
  */
 static void
 lcd_wr_bit(int b) {
-	gpio_write(lcd_sdin,b);
-	gpio_write(lcd_sclk,1);
-	gpio_write(lcd_sclk,0);
+	lcd_sdin_write(b);
+	lcd_sclk_set();
+	lcd_sclk_clr();
 }
 
 /*
@@ -363,41 +368,32 @@ lcd_puts(const char *text) {
  *********************************************************************/
 void
 lcd_init(int vop) {
+	gpio_fsel_t tx;
+	int rc;
+
 	if ( vop > 0 )
 		lcd_vop = vop;		/* Use this new value */
 
-	/* No outputs yet.. */
-	gpio_config(lcd_ce,Input);
-	gpio_config(lcd_res,Input);
-	gpio_config(lcd_d_c,Input);
-	gpio_config(lcd_sdin,Input);
-	gpio_config(lcd_sclk,Input);
-
-	/* Configure all pins as high */
-	gpio_write(lcd_ce,1);
-	gpio_write(lcd_res,1);
-	gpio_write(lcd_d_c,1);
-	gpio_write(lcd_sdin,1);
-	gpio_write(lcd_sclk,1);
-
-	/* Now assert outputs */
-	gpio_config(lcd_ce,Output);
-	gpio_config(lcd_res,Output);
-	gpio_config(lcd_d_c,Output);
-	gpio_config(lcd_sdin,Output);
-	gpio_config(lcd_sclk,Output);
+	/* Configure all pins as high, before they become outputs */
+	gpio_set_mask(1 << lcd_ce | 1 << lcd_res | 1 << lcd_d_c | 1 << lcd_sdin | 1 << lcd_sclk);
+
+	/* Now assert outputs, in one commit */
+	gpio_fsel_begin(&tx);
+	gpio_fsel_dir(&tx,lcd_ce,Output);
+	gpio_fsel_dir(&tx,lcd_res,Output);
+	gpio_fsel_dir(&tx,lcd_d_c,Output);
+	gpio_fsel_dir(&tx,lcd_sdin,Output);
+	gpio_fsel_dir(&tx,lcd_sclk,Output);
+	rc = gpio_fsel_commit(&tx);
+	assert(!rc);
 
 	lcd(LCD_Command);	/* Command mode */
 
-	gpio_write(lcd_res,0);	/* Apply /RESET */
-	gpio_read(lcd_res);	/* Delay a little */
-	gpio_read(lcd_res);	/* Delay a little */
-	gpio_read(lcd_res);	/* Delay a little */
+	lcd_res_write(0);	/* Apply /RESET */
+	gpio_delay_ns(LCD_RESET_NS);
 
-	gpio_write(lcd_res,1);	/* Deactivate /RESET */
-	gpio_read(lcd_res);	/* Delay a little more */
-	gpio_read(lcd_res);	/* Delay a little */
-	gpio_read(lcd_res);	/* Delay a little */
+	lcd_res_write(1);	/* Deactivate /RESET */
+	gpio_delay_ns(LCD_RESET_NS);
 
 	lcd_wr_byte(0x21);	/* Chip Active, Extended instructions enabled */
 	lcd_wr_byte(lcd_vop);	/* Set Vop level */
@@ -556,9 +552,20 @@ int
 main(int argc,char **argv) {
 	int tty = 0;				/* Use stdin */
 	struct termios sv_ios, ios;
-	int rc, quit;
+	int rc, quit, optch;
 	char ch;
 
+	while ( (optch = getopt(argc,argv,"R:h")) != EOF )
+		switch ( optch ) {
+		case 'R' :
+			rt_optarg(optarg);	/* Real-time CPU[,priority] */
+			break;
+		case 'h' :
+		default :
+			fprintf(stderr,"Usage: %s [-R cpu[,priority]]\n",argv[0]);
+			exit(1);
+		}
+
  	rc = tcgetattr(tty,&sv_ios);		/* Save current settings */
 	assert(!rc);
 	ios = sv_ios;
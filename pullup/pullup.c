@@ -11,7 +11,7 @@
 #include <sys/mman.h>
 #include <signal.h>
 
-#include "gpio_io.c"                    /* GPIO routines */
+#include "gpio_io.h"                    /* GPIO routines (libgpio) */
 #include "timed_wait.c"                 /* Delay */
 
 /*********************************************************************
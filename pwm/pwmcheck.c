@@ -0,0 +1,323 @@
+/*********************************************************************
+ * pwmcheck.c : Check the PWM/DMA register sequences on simulated
+ *              registers
+ *
+ * ./pwmcheck [-v]
+ *
+ * pwm_io.c and dma_io.c are compiled into this program with
+ * -DPERI_TRACE, so every PWM, clock and DMA register access comes
+ * through peri_trace_rd()/peri_trace_wr() below. Those log the
+ * writes and model what the hardware does with them (CLRF and the
+ * clock password read back as 0, status bits clear when written
+ * with 1, a DMA abort or reset idles the channel), on the memory of
+ * the sim backend. Each check then compares the writes, their order
+ * and the final register and control block contents against the
+ * BCM2835 peripheral manual. -v lists every write.
+ *
+ * Exits 0 when all checks pass.
+ *********************************************************************/
+
+#define PERI_TRACE			/* Prototypes for the trace hooks */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gpio_io.h"			/* GPIO access (libgpio) */
+#include "pwm_io.h"			/* PWM routines (libgpio) */
+
+#define MAX_TRACE	4096
+
+typedef struct {
+	const char	*blk;		/* "pwm", "clk" or "dma" */
+	unsigned	reg;		/* Word index */
+	unsigned	value;		/* Value written */
+} trace_t;
+
+static trace_t trace[MAX_TRACE];
+static unsigned ntrace = 0;
+static volatile unsigned *pwm = 0;	/* The PWM registers pwm_io uses */
+static int verbose = 0;
+static unsigned checks = 0, failures = 0;
+
+unsigned
+peri_trace_rd(const char *blk,volatile unsigned *regs,unsigned reg) {
+	return regs[reg];
+}
+
+void
+peri_trace_wr(const char *blk,volatile unsigned *regs,unsigned reg,unsigned value) {
+	const char *b = !strcmp(blk,"dmab") ? "dma" : blk;
+
+	if ( ntrace < MAX_TRACE ) {
+		trace[ntrace].blk = b;
+		trace[ntrace].reg = reg;
+		trace[ntrace++].value = value;
+	}
+	if ( verbose )
+		printf("\t%s[%u] = 0x%08X\n",b,reg,value);
+
+	if ( !strcmp(b,"pwm") && reg == PWM_CTL )
+		regs[reg] = value & ~PWM_CLRF;		/* Self clearing */
+	else if ( !strcmp(b,"pwm") && reg == PWM_STA )
+		regs[reg] &= ~(value & PWM_STA_ERRORS);	/* Write 1 to clear */
+	else if ( !strcmp(b,"clk") )
+		regs[reg] = value & 0x00FFFFFF;		/* Password reads 0 */
+	else if ( !strcmp(b,"dma") && reg == DMA_CS && (value & (DMA_CS_ABORT|DMA_CS_RESET)) )
+		regs[reg] = 0;				/* Channel idle */
+	else if ( !strcmp(b,"dma") && reg == DMA_CS )
+		regs[reg] = (regs[reg] & ~(value & (DMA_CS_INT|DMA_CS_END))) | (value & ~(DMA_CS_INT|DMA_CS_END));
+	else	regs[reg] = value;
+}
+
+/*
+ * Record a check's result :
+ */
+static void
+check(int ok,const char *what) {
+	++checks;
+	if ( !ok )
+		++failures;
+	printf("%s  %s\n",ok ? "pass" : "FAIL",what);
+}
+
+/*
+ * Index of the first write of value (or any value, if any) to
+ * blk[reg] at or after from, or -1 :
+ */
+static int
+find(unsigned from,const char *blk,unsigned reg,unsigned value,int any) {
+	unsigned x;
+
+	for ( x=from; x<ntrace; ++x )
+		if ( !strcmp(trace[x].blk,blk) && trace[x].reg == reg && (any || trace[x].value == value) )
+			return x;
+	return -1;
+}
+
+#define WROTE(from,blk,reg,value)	find((from),(blk),(reg),(value),0)
+#define WROTE_ANY(from,blk,reg)		find((from),(blk),(reg),0,1)
+
+/*
+ * The function select code of gpio :
+ */
+static unsigned
+fsel(int gpio) {
+	return ugpio[GPFSEL0 + gpio / 10] >> (gpio % 10 * 3) & 7;
+}
+
+static void
+check_clock(void) {
+	unsigned t = ntrace;
+	int a, b, c, d;
+
+	check(pwm_clock(1000000.0) == 0,"pwm_clock(1 MHz) in range");
+	a = WROTE(t,"clk",PWMCLK_CNTL,CLK_PASSWD|CLK_KILL);
+	b = WROTE(t,"clk",PWMCLK_DIV,CLK_PASSWD|19 << 12);
+	c = WROTE(t,"clk",PWMCLK_CNTL,CLK_PASSWD|CLK_SRC_OSC);
+	d = WROTE(t,"clk",PWMCLK_CNTL,CLK_PASSWD|CLK_SRC_OSC|CLK_ENAB);
+	check(a >= 0 && a < b && b < c && c < d,"clock killed, divided by 19, then sourced and enabled");
+	check(WROTE_ANY(t,"pwm",PWM_CTL) >= 0 && WROTE_ANY(t,"pwm",PWM_CTL) < a,"channels stopped before the clock");
+	check(!(trace[WROTE_ANY(t,"pwm",PWM_CTL)].value & (PWM_PWEN(1)|PWM_PWEN(2))),"PWEN1 and PWEN2 cleared");
+
+	t = ntrace;
+	check(pwm_clock(1e9) == -1 && WROTE(t,"clk",PWMCLK_DIV,CLK_PASSWD|1 << 12) >= 0,"too fast: divisor clamped at 1");
+	t = ntrace;
+	check(pwm_clock(100.0) == 1 && WROTE(t,"clk",PWMCLK_DIV,CLK_PASSWD|0xFFF << 12) >= 0,"too slow: divisor clamped at 4095");
+}
+
+static void
+check_channels(void) {
+	unsigned t = ntrace, ctl;
+	int a, b;
+
+	check(pwm_channel(2,19,pwm_mode_ms,0) == 0 && fsel(19) == GPIO_FSEL_ALT(5),"channel 2 on GPIO 19 is ALT5");
+	ctl = PERI_RD(pwm,PWM_CTL);
+	check((ctl & 0xFF00) == PWM_MSEN(2),"channel 2 mark-space, stopped");
+	check(pwm_channel(2,12,pwm_mode_pwm,0) == -1,"GPIO 12 refused for channel 2");
+	check(pwm_channel(2,13,pwm_mode_ms,0) == 0 && fsel(13) == GPIO_FSEL_ALT(0),"channel 2 on GPIO 13 is ALT0");
+
+	t = ntrace;
+	pwm_set(2,30,100);
+	a = WROTE(t,"pwm",PWM_RNG2,100);
+	b = WROTE(t,"pwm",PWM_DAT2,30);
+	check(a >= 0 && a < b,"pwm_set(2): RNG2 then DAT2");
+
+	check(pwm_channel(1,12,pwm_mode_serial,PWM_FIFO|PWM_INVERT|PWM_SILENCE_HIGH) == 0
+		&& fsel(12) == GPIO_FSEL_ALT(0),"channel 1 on GPIO 12 is ALT0");
+	ctl = PERI_RD(pwm,PWM_CTL);
+	check((ctl & 0xFF) == (PWM_MODE(1)|PWM_USEF(1)|PWM_POLA(1)|PWM_SBIT(1)),"channel 1 serializer, FIFO, inverted, idle high");
+	check((ctl & 0xFF00) == PWM_MSEN(2),"channel 2 settings kept");
+
+	t = ntrace;
+	pwm_start(2,1);
+	pwm_start(1,1);
+	ctl = PERI_RD(pwm,PWM_CTL);
+	check((ctl & (PWM_PWEN(1)|PWM_PWEN(2))) == (PWM_PWEN(1)|PWM_PWEN(2)),"both channels started");
+	pwm_start(2,0);
+	check(!(PERI_RD(pwm,PWM_CTL) & PWM_PWEN(2)) && (PERI_RD(pwm,PWM_CTL) & PWM_PWEN(1)),"channel 2 stopped alone");
+
+	pwm[PWM_STA] = PWM_STA_WERR|PWM_STA_BERR|PWM_STA_EMPT;
+	pwm_channel(1,18,pwm_mode_pwm,0);
+	check((PERI_RD(pwm,PWM_STA) & PWM_STA_ERRORS) == 0,"pwm_channel() clears error flags");
+}
+
+static void
+check_fifo(void) {
+	unsigned words[5] = { 1, 2, 3, 0xDEADBEEF, 5 }, t, x, ok = 1;
+
+	t = ntrace;
+	pwm_fifo_clear();
+	check(WROTE_ANY(t,"pwm",PWM_CTL) >= 0 && (trace[WROTE_ANY(t,"pwm",PWM_CTL)].value & PWM_CLRF),"pwm_fifo_clear() sets CLRF");
+
+	t = ntrace;
+	check(pwm_fifo_write(words,5) == 5,"FIFO takes 5 words");
+	for ( x=0; x<5; ++x ) {
+		int i = WROTE_ANY(t,"pwm",PWM_FIF1);
+		ok &= i >= 0 && trace[i].value == words[x];
+		t = i + 1;
+	}
+	check(ok,"FIF1 written in order");
+
+	pwm[PWM_STA] |= PWM_STA_FULL;
+	check(pwm_fifo_write(words,5) == 0,"full FIFO takes nothing");
+	pwm[PWM_STA] &= ~PWM_STA_FULL;
+}
+
+/*
+ * Walk a control block chain, checking it moves words[0..n-1] :
+ */
+static void
+check_chain(pwm_stream_t *st,const unsigned *words,unsigned n,int loop) {
+	const dma_mem_t *mem = pwm_stream_mem(st);
+	volatile unsigned *dma = dma_channel(DMA_CHANNEL);
+	unsigned first = PERI_RD(dma,DMA_CONBLK_AD), bus = first, total = 0, ncb = 0;
+	unsigned ti = DMA_TI_NO_WIDE|DMA_TI_WAIT_RESP|DMA_TI_DEST_DREQ|DMA_TI_PERMAP(DMA_DREQ_PWM)|DMA_TI_SRC_INC;
+	int ok = 1, fits = 1;
+	dma_cb_t *cb;
+	unsigned *src;
+
+	while ( bus && ncb < 100 ) {
+		if ( !(cb = dma_virt(mem,bus)) || (bus & 31) ) {
+			ok = 0;
+			break;
+		}
+		++ncb;
+		ok &= cb->ti == ti && cb->dest_ad == 0x7E20C018 && cb->stride == 0;
+		fits &= cb->txfr_len <= DMA_LITE_MAX && !(cb->txfr_len & 3);
+		src = dma_virt(mem,cb->source_ad);
+		ok &= src && !memcmp(src,words + total / 4,cb->txfr_len);
+		total += cb->txfr_len;
+		bus = cb->nextconbk;
+		if ( bus == first )
+			break;			/* Looped */
+	}
+	printf("\t%u control blocks, %u bytes\n",ncb,total);
+	check(ok,"blocks move the words to FIF1 (0x7E20C018), paced by PWM DREQ");
+	check(fits,"blocks fit a lite channel");
+	check(total == n * 4,"every word once per pass");
+	check(loop ? bus == first : bus == 0,loop ? "chain loops to the first block" : "chain ends");
+}
+
+static void
+check_stream(void) {
+	static unsigned words[40000];
+	volatile unsigned *dmab;
+	pwm_stream_t *st;
+	unsigned x, t;
+	int a, b, c, d;
+
+	for ( x=0; x<40000; ++x )
+		words[x] = x * 2654435761u;
+
+	st = pwm_stream_open(DMA_CHANNEL,40000);
+	check(st != 0,"stream on DMA channel 10");
+	if ( !st )
+		return;
+	dmab = dma_channel(DMA_CHANNEL) - DMA_CHANNEL * DMA_CHAN_WORDS;
+	check(dmab[DMA_ENABLE] & 1 << DMA_CHANNEL,"channel 10 enabled");
+
+	t = ntrace;
+	check(pwm_stream_play(st,words,40000,1) == 0,"play 40000 words, looping");
+	a = WROTE(t,"pwm",PWM_DMAC,PWM_DMAC_ENAB|PWM_DMAC_PANIC(7)|PWM_DMAC_DREQ(3));
+	b = WROTE_ANY(a < 0 ? t : a,"pwm",PWM_CTL);
+	for ( c=WROTE_ANY(t,"dma",DMA_CONBLK_AD); c >= 0 && !trace[c].value; )
+		c = WROTE_ANY(c+1,"dma",DMA_CONBLK_AD);	/* Past the reset's 0 */
+	d = WROTE(c < 0 ? t : c,"dma",DMA_CS,DMA_CS_WAIT_WRITES|DMA_CS_PANIC(15)|DMA_CS_PRIORITY(8)|DMA_CS_ACTIVE);
+	check(a >= 0 && b > a && (trace[b].value & PWM_CLRF),"DREQ enabled, then FIFO cleared");
+	check(WROTE(t,"dma",DMA_CS,DMA_CS_RESET) >= 0 && WROTE(t,"dma",DMA_CS,DMA_CS_RESET) < c,"channel reset before loading");
+	check(c > b && d > c,"control block loaded, then channel activated");
+	check_chain(st,words,40000,1);
+
+	t = ntrace;
+	check(pwm_stream_play(st,words,100,0) == 0,"play 100 words once");
+	check(WROTE(t,"dma",DMA_CS,DMA_CS_ABORT) >= 0,"running stream aborted first");
+	check_chain(st,words,100,0);
+
+	check(pwm_stream_play(st,words,40001,0) == -1,"too many words refused");
+
+	t = ntrace;
+	pwm_stream_stop(st);
+	check(WROTE(t,"pwm",PWM_DMAC,0) >= 0 && !pwm_stream_busy(st),"stop: DMA idle, PWM DREQ off");
+	pwm_stream_close(st);
+}
+
+static void
+check_legacy(void) {
+	unsigned t, ctl;
+	int a, b, c, d;
+
+	pwm_channel(1,12,pwm_mode_serial,PWM_FIFO);
+	pwm_frequency(1000.0);
+	check(fsel(18) == GPIO_FSEL_ALT(5),"pwm_frequency(): GPIO 18 is ALT5");
+	check((PERI_RD(pwm,PWM_CTL) & 0xFF) == 0,"pwm_frequency(): channel 1 PWM mode, stopped");
+
+	t = ntrace;
+	ctl = PERI_RD(pwm,PWM_CTL);
+	pwm_ratio(25,100);
+	a = WROTE(t,"pwm",PWM_CTL,ctl & ~PWM_PWEN(1));
+	b = WROTE(t,"pwm",PWM_RNG1,100);
+	c = WROTE(t,"pwm",PWM_DAT1,25);
+	d = WROTE(t,"pwm",PWM_CTL,ctl | PWM_PWEN(1));
+	check(a >= 0 && a < b && b < c && c < d && (PERI_RD(pwm,PWM_CTL) & PWM_PWEN(1)),"pwm_ratio(): stop, RNG1, DAT1, start");
+
+	pwm_markspace(1);
+	check(PERI_RD(pwm,PWM_CTL) & PWM_MSEN(1),"pwm_markspace(1) sets MSEN1");
+	pwm_enable(0);
+	check(!(PERI_RD(pwm,PWM_CTL) & PWM_PWEN(1)) && (PERI_RD(pwm,PWM_CTL) & PWM_MSEN(1)),"pwm_enable(0) clears only PWEN1");
+}
+
+int
+main(int argc,char **argv) {
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"vh")) != EOF )
+		switch ( optch ) {
+		case 'v' :
+			verbose = 1;
+			break;
+		default :
+			fprintf(stderr,"Usage: %s [-v]\n",argv[0]);
+			exit(1);
+		}
+
+	if ( gpio_select_backend("sim") || pwm_init() )
+		return 2;
+	pwm = gpio_map_peri(PWM_OFFSET);	/* Same mapping */
+
+	check_clock();
+	check_channels();
+	check_fifo();
+	check_stream();
+	check_legacy();
+
+	printf("%u checks, %u failed\n",checks,failures);
+	return failures ? 1 : 0;
+}
+
+/*********************************************************************
+ * End pwmcheck.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
@@ -12,7 +12,8 @@
 #include <math.h>
 #include <pthread.h>
 
-#include "gpio_io.c"
+#include "gpio_io.h"
+#include "rt_setup.h"
 
 typedef struct {
 	int		gpio;	/* GPIO output pin */
@@ -24,6 +25,8 @@ typedef struct {
 	volatile char	stopf;	/* True when thread to stop */
 } PWM;
 
+static const char *rt_arg = 0;	/* -R cpu[,priority] */
+
 /*
  * Timed wait from a float
  */
@@ -50,6 +53,9 @@ soft_pwm(void *arg) {
 	PWM *pwm = (PWM *)arg;
 	double fperiod, percent, ontime;
 
+	if ( rt_arg )
+		rt_optarg(rt_arg);	/* Real-time PWM thread */
+
 	while ( !pwm->stopf ) {
 		fperiod = 1.0 / pwm->freq;
 		percent = (double) pwm->n / (double) pwm->m;
@@ -80,8 +86,7 @@ pwm_open(int gpio,double freq) {
 	pwm->chgf = 0;
 	pwm->stopf = 0;
 
-	INP_GPIO(pwm->gpio);
-	OUT_GPIO(pwm->gpio);
+	gpio_config(pwm->gpio,Output);
 	return pwm;
 }
 
@@ -120,7 +125,22 @@ main(int argc,char **argv) {
 	FILE *pipe;
 	char buf[64];
 	float pct, total;
-    
+	int optch;
+
+	while ( (optch = getopt(argc,argv,"R:h")) != EOF )
+		switch ( optch ) {
+		case 'R' :
+			rt_arg = optarg;
+			break;
+		case 'h' :
+		default :
+			fprintf(stderr,"Usage: %s [-R cpu[,priority]] [n [m [freq]]]\n",argv[0]);
+			exit(1);
+		}
+
+	argc -= optind - 1;		/* Positional arguments follow */
+	argv += optind - 1;
+
 	if ( argc > 1 )
 		n = atoi(argv[1]);
 	if ( argc > 2 )
@@ -0,0 +1,136 @@
+/*********************************************************************
+ * ws2812.c : Drive a WS2812 (NeoPixel) LED strip by PWM and DMA
+ *
+ * ./ws2812 [-g gpio] [-c channel] [-d dma] [-r] rrggbb ...
+ *
+ * Each argument is the colour of the next LED. A WS2812 bit lasts
+ * 1.25 us (800 kHz): about 0.8 us high then 0.45 us low for a 1,
+ * 0.4 us high then 0.85 us low for a 0. At a 2.4 MHz serializer
+ * clock a bit is three PWM bits, 110 or 100, packed 32 to a FIFO
+ * word, and a low tail of at least 50 us latches the colours. The
+ * words are played by DMA, so the timing does not depend upon
+ * scheduling. -r repeats the colours until interrupted.
+ *
+ * The default is channel 1 on GPIO 18 (ALT5) and DMA channel 10.
+ * GPIO_BACKEND=sim runs it without hardware.
+ *********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include "gpio_io.h"			/* gpio_get_backend() (libgpio) */
+#include "pwm_io.h"			/* PWM routines (libgpio) */
+
+#define WS_BIT_HZ	2400000.0	/* Serializer bits: 3 per LED bit */
+#define WS_LATCH_WORDS	4		/* 128 bits low: 53 us */
+#define MAX_LEDS	1024
+
+static volatile int is_signaled = 0;
+
+static void
+sig_handler(int signo) {
+	is_signaled = 1;
+}
+
+/*
+ * Append one serializer bit to words[], MSB first :
+ */
+static void
+put_bit(unsigned *words,unsigned *nbits,int bit) {
+	if ( bit )
+		words[*nbits / 32] |= 0x80000000u >> (*nbits % 32);
+	++*nbits;
+}
+
+/*
+ * Encode GRB colours as serializer words. Returns the word count.
+ */
+static unsigned
+encode(const unsigned *rgb,unsigned nleds,unsigned *words) {
+	unsigned nbits = 0, x, grb;
+	int b;
+
+	memset(words,0,((nleds * 72 + 31) / 32 + WS_LATCH_WORDS) * 4);
+	for ( x=0; x<nleds; ++x ) {
+		grb = (rgb[x] >> 8 & 0xFF) << 16 | (rgb[x] >> 16 & 0xFF) << 8 | (rgb[x] & 0xFF);
+		for ( b=23; b>=0; --b ) {
+			put_bit(words,&nbits,1);
+			put_bit(words,&nbits,grb >> b & 1);
+			put_bit(words,&nbits,0);
+		}
+	}
+	return (nbits + 31) / 32 + WS_LATCH_WORDS;
+}
+
+int
+main(int argc,char **argv) {
+	static unsigned rgb[MAX_LEDS], words[MAX_LEDS * 72 / 32 + WS_LATCH_WORDS + 1];
+	int optch, gpio = 18, ch = 1, dma = DMA_CHANNEL, repeat = 0;
+	unsigned nleds = 0, nwords;
+	pwm_stream_t *st;
+	char *ep;
+
+	while ( (optch = getopt(argc,argv,"g:c:d:rh")) != EOF )
+		switch ( optch ) {
+		case 'g' :
+			gpio = atoi(optarg);
+			break;
+		case 'c' :
+			ch = atoi(optarg);
+			break;
+		case 'd' :
+			dma = atoi(optarg);
+			break;
+		case 'r' :
+			repeat = 1;
+			break;
+		case 'h' :
+		default :
+usage:			fprintf(stderr,"Usage: %s [-g gpio] [-c channel] [-d dma] [-r] rrggbb ...\n",argv[0]);
+			exit(1);
+		}
+
+	for ( ; optind < argc && nleds < MAX_LEDS; ++optind ) {
+		rgb[nleds++] = strtoul(argv[optind],&ep,16);
+		if ( *ep )
+			goto usage;
+	}
+	if ( !nleds )
+		goto usage;
+
+	nwords = encode(rgb,nleds,words);
+
+	if ( pwm_init() )
+		return 2;
+	pwm_clock(WS_BIT_HZ);
+	if ( pwm_channel(ch,gpio,pwm_mode_serial,PWM_FIFO) )
+		return 2;
+	pwm_set(ch,0,32);			/* 32 bits per word */
+	if ( !(st = pwm_stream_open(dma,nwords)) )
+		return 2;
+
+	signal(SIGINT,sig_handler);
+	signal(SIGTERM,sig_handler);
+
+	pwm_start(ch,1);
+	pwm_stream_play(st,words,nwords,repeat);
+	printf("%u LEDs, %u words on DMA channel %d\n",nleds,nwords,dma);
+
+	while ( !is_signaled && pwm_stream_busy(st) && (repeat || gpio_get_backend() != &gpio_backend_sim) )
+		usleep(1000);
+	if ( !repeat )
+		usleep(100);			/* Let the FIFO drain */
+
+	pwm_stream_close(st);
+	pwm_start(ch,0);
+	return 0;
+}
+
+/*********************************************************************
+ * End ws2812.c - by Warren Gay
+ * Mastering the Raspberry Pi - ISBN13: 978-1-484201-82-4
+ * This source code is placed into the public domain.
+ *********************************************************************/
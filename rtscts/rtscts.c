@@ -10,21 +10,21 @@
 #include <setjmp.h>
 #include <sys/mman.h>
 #include <signal.h>
+#include <assert.h>
 
-#include "gpio_io.c"			/* GPIO routines */
-
-static inline void
-gpio_setalt(int gpio,unsigned alt) {
-	INP_GPIO(gpio);
-	SET_GPIO_ALT(gpio,alt);
-}
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
 
 int
 main(int argc,char **argv) {
+	gpio_fsel_t tx;
+	int rc;
 
 	gpio_init();   			/* Initialize GPIO access */
-	gpio_setalt(17,3);		/* GPIO 17 ALT = 3 */
-	gpio_setalt(30,3);		/* GPIO 30 ALT = 3 */
+	gpio_fsel_begin(&tx);
+	gpio_fsel_alt(&tx,17,3);	/* GPIO 17 ALT = 3 */
+	gpio_fsel_alt(&tx,30,3);	/* GPIO 30 ALT = 3 */
+	rc = gpio_fsel_commit(&tx);
+	assert(!rc);
 
 	return 0;
 }
@@ -14,7 +14,8 @@
 #include <signal.h>
 #include <assert.h>
 
-#include "gpio_io.c"			/* GPIO routines */
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
+#include "rt_setup.h"			/* rt_setup() (libgpio) */
 #include "timed_wait.c"			/* timed_wait() */
 
 static const int steps_per_360 = 100;	/* Full steps per rotation */
@@ -61,9 +62,15 @@ set_mode(int mode) {
  *********************************************************************/
 static void
 drive(int pins) {
+	unsigned value = 0, mask = 0;
 	short x;
-	for ( x=0; x<4; ++x )
-		gpio_write(gpios[x],pins & (8>>x) ? 1 : 0);
+
+	for ( x=0; x<4; ++x ) {
+		mask |= 1 << gpios[x];
+		if ( pins & (8>>x) )
+			value |= 1 << gpios[x];
+	}
+	gpio_write_mask(value,mask);	/* All fields change together */
 }
 
 /*********************************************************************
@@ -158,11 +165,23 @@ int
 main(int argc,char **argv) {
 	int tty = 0;				/* Use stdin */
 	struct termios sv_ios, ios;
-	int x, rc;
+	gpio_fsel_t tx;				/* GPIO configuration */
+	int x, rc, optch;
 	char ch;
 
-	if ( argc >= 2 )
-		drive_mode = atoi(argv[1]);	/* Drive mode 0-2 */
+	while ( (optch = getopt(argc,argv,"R:h")) != EOF )
+		switch ( optch ) {
+		case 'R' :
+			rt_optarg(optarg);	/* Real-time CPU[,priority] */
+			break;
+		case 'h' :
+		default :
+			fprintf(stderr,"Usage: %s [-R cpu[,priority]] [drive_mode]\n",argv[0]);
+			exit(1);
+		}
+
+	if ( optind < argc )
+		drive_mode = atoi(argv[optind]); /* Drive mode 0-2 */
 
  	rc = tcgetattr(tty,&sv_ios);		/* Save current settings */
 	assert(!rc);
@@ -174,8 +193,11 @@ main(int argc,char **argv) {
 
 	gpio_init();    			/* Initialize GPIO access */
 	drive(0);				/* Turn off output */
+	gpio_fsel_begin(&tx);
 	for ( x=0; x<4; ++x )
-		gpio_config(gpios[x],Output);	/* Set GPIO pin as Output */
+		gpio_fsel_dir(&tx,gpios[x],Output); /* Set GPIO pin as Output */
+	rc = gpio_fsel_commit(&tx);
+	assert(!rc);
 
 	help();
 
@@ -243,8 +265,10 @@ main(int argc,char **argv) {
 	puts("\nExit.");
 
 	drive(0);
+	gpio_fsel_begin(&tx);
 	for ( x=0; x<4; ++x )
-		gpio_config(gpios[x],Input);	/* Set GPIO pin as Input */
+		gpio_fsel_dir(&tx,gpios[x],Input); /* Set GPIO pin as Input */
+	gpio_fsel_commit(&tx);
 
 	tcsetattr(tty,TCSAFLUSH,&sv_ios);	/* Restore terminal mode */
 	return 0;
@@ -1 +0,0 @@
-../dht11/gpio_io.c
\ No newline at end of file
@@ -11,7 +11,7 @@
 #include <sys/mman.h>
 #include <signal.h>
 
-#include "gpio_io.c"			/* GPIO routines */
+#include "gpio_io.h"			/* GPIO routines (libgpio) */
 
 static struct {
 	int		gpio;
@@ -265,14 +265,16 @@ gpio_get_alt(unsigned gpio) {
 
 int
 main(int argc,char **argv) {
+	unsigned long long levels;
 	unsigned a, b;
 	int x;
 
 	gpio_init();    			/* Initialize GPIO access */
+	levels = gpio_read_all64();		/* Snapshot GPLEV0 and GPLEV1 */
 
-	for ( x=0; x<46; ++x ) {
+	for ( x=0; x<sizeof gpio_funcs/sizeof gpio_funcs[0]; ++x ) {
 		a = gpio_get_alt(x);
-		b = gpio_read(x);
+		b = levels >> x & 1;
 		printf("GPIO %02d  %-4s ",x,gpio_funcs[x].pullup);
 		if ( a < 6 ) {
 			printf("%-10s (ALT %u)  ",gpio_funcs[x].alt[a],a);